@@ -64,6 +64,9 @@ public:
         this->theme = "default";
         this->textEditorOpenFolder = "";
         this->textEditorGotoLine = "";
+        this->prefetchMemoryBudget = 64;
+        this->mapCacheMemoryBudget = 256;
+        this->undoHistoryMemoryBudget = 16;
     }
     void setRecentProject(QString project);
     void setReopenOnLaunch(bool enabled);
@@ -87,6 +90,9 @@ public:
     void setTextEditorOpenFolder(const QString &command);
     void setTextEditorGotoLine(const QString &command);
     void setPaletteEditorBitDepth(int bitDepth);
+    void setPrefetchMemoryBudget(int megabytes);
+    void setMapCacheMemoryBudget(int megabytes);
+    void setUndoHistoryMemoryBudget(int megabytes);
     QString getRecentProject();
     bool getReopenOnLaunch();
     MapSortOrder getMapSortOrder();
@@ -109,6 +115,9 @@ public:
     QString getTextEditorOpenFolder();
     QString getTextEditorGotoLine();
     int getPaletteEditorBitDepth();
+    int getPrefetchMemoryBudget();
+    int getMapCacheMemoryBudget();
+    int getUndoHistoryMemoryBudget();
 protected:
     virtual QString getConfigFilepath() override;
     virtual void parseConfigKeyValue(QString key, QString value) override;
@@ -149,6 +158,9 @@ private:
     QString textEditorOpenFolder;
     QString textEditorGotoLine;
     int paletteEditorBitDepth;
+    int prefetchMemoryBudget; // In megabytes
+    int mapCacheMemoryBudget; // In megabytes
+    int undoHistoryMemoryBudget; // In megabytes, per map
 };
 
 extern PorymapConfig porymapConfig;
@@ -232,6 +244,8 @@ public:
     void reset(BaseGameVersion baseGameVersion);
     void setBaseGameVersion(BaseGameVersion baseGameVersion);
     BaseGameVersion getBaseGameVersion();
+    // When false (e.g. in headless mode), settings that can't be detected use their defaults instead of asking the user.
+    void setInteractive(bool interactive) { this->interactive = interactive; }
     QString getBaseGameVersionString();
     QString getBaseGameVersionString(BaseGameVersion version);
     BaseGameVersion stringToBaseGameVersion(QString string, bool * ok = nullptr);
@@ -331,6 +345,7 @@ private:
     uint32_t metatileTerrainTypeMask;
     uint32_t metatileEncounterTypeMask;
     uint32_t metatileLayerTypeMask;
+    bool interactive = true;
     bool enableMapAllowFlags;
 };
 
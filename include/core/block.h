@@ -18,6 +18,11 @@ public:
     uint16_t collision:2;
     uint16_t elevation:4;
     uint16_t rawValue() const;
+
+    // The bits of each field in rawValue()
+    static const uint16_t metatileIdMask = 0x03FF;
+    static const uint16_t collisionMask  = 0x0C00;
+    static const uint16_t elevationMask  = 0xF000;
 };
 
 #endif // BLOCK_H
@@ -11,6 +11,55 @@ class Blockdata : public QVector<Block>
 {
 public:
     QByteArray serialize() const;
+
+    // Returns the indexes of the blocks whose raw values (see Block::rawValue) have 'value' in the bits of 'mask'.
+    // The blocks are compared several at a time where the platform supports it.
+    QVector<int> findMatching(uint16_t mask, uint16_t value) const;
+};
+
+// A new value for the block at an index of a Blockdata (see Map::setBlocks)
+struct BlockUpdate {
+    int index;
+    Block block;
+};
+
+// The blocks that differ between two versions of a Blockdata, stored as runs of consecutive changed blocks.
+// This lets edits that only change part of a map be undone and redone without storing or visiting the whole map.
+class BlockdataDelta
+{
+public:
+    struct Run {
+        int start;
+        Blockdata oldBlocks;
+        Blockdata newBlocks;
+    };
+
+    BlockdataDelta() = default;
+    BlockdataDelta(const Blockdata &oldBlocks, const Blockdata &newBlocks);
+    // The changes from the old blocks at the given indexes to their current values in 'blockdata'.
+    // If an index is given more than once, its first old block is used.
+    BlockdataDelta(const QVector<BlockUpdate> &oldBlocks, const Blockdata &blockdata);
+
+    // Combines this delta with a delta that was applied after it, so that it goes from this delta's old blocks
+    // to the other delta's new blocks. Blocks that end up unchanged are dropped.
+    void merge(const BlockdataDelta &other);
+
+    // Writes the new (or, if 'undo' is true, the old) blocks of each run into the blockdata.
+    void apply(Blockdata *blockdata, bool undo) const;
+
+    const QVector<Run> &getRuns() const { return runs; }
+    bool isEmpty() const { return runs.isEmpty(); }
+    qint64 byteSize() const;
+
+private:
+    QVector<Run> runs;
+
+    struct Change {
+        int index;
+        Block oldBlock;
+        Block newBlock;
+    };
+    void appendChange(const Change &change);
 };
 
 #endif // BLOCKDATA_H
@@ -5,6 +5,7 @@
 #include "blockdata.h"
 
 #include <QUndoCommand>
+#include <QUndoStack>
 #include <QList>
 
 class MapPixmapItem;
@@ -39,13 +40,43 @@ enum CommandId {
 #define IDMask_EventType_Trigger (1 << 11)
 #define IDMask_EventType_Heal    (1 << 12)
 
+/// Base class of the commands that store map or border blocks.
+/// Once a map's edit history uses more memory than its budget, the oldest of these
+/// are compacted and then released (see trimMapEditHistory).
+class MapBlocksCommand : public QUndoCommand {
+public:
+    MapBlocksCommand(QUndoCommand *parent = nullptr) : QUndoCommand(parent) {}
+
+    // Roughly how much memory the stored blocks use.
+    virtual qint64 byteSize() const = 0;
+
+    // The command's changes, if they're stored as a delta rather than as snapshots.
+    virtual BlockdataDelta *getDelta() { return nullptr; }
+
+    // Discards the stored blocks. Undoing or redoing the command has no effect afterwards.
+    void release();
+    bool isReleased() const { return released; }
+
+protected:
+    bool released = false;
+    virtual void releaseBlocks() = 0;
+};
+
+/// Limits the memory used by the block commands in a map's edit history.
+/// The oldest consecutive block deltas are merged into the first of them, then the oldest
+/// block commands are released, until the history fits in maxBytes. The most recent
+/// command is never changed. A maxBytes of 0 or less means there's no limit.
+void trimMapEditHistory(QUndoStack *history, qint64 maxBytes);
+
 /// Implements a command to commit metatile paint actions
 /// onto the map using the pencil tool.
-class PaintMetatile : public QUndoCommand {
+class PaintMetatile : public MapBlocksCommand {
 public:
     PaintMetatile(Map *map,
         const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
         unsigned actionId, QUndoCommand *parent = nullptr);
+    PaintMetatile(Map *map, const BlockdataDelta &delta,
+        unsigned actionId, QUndoCommand *parent = nullptr);
 
     void undo() override;
     void redo() override;
@@ -53,11 +84,17 @@ public:
     bool mergeWith(const QUndoCommand *command) override;
     int id() const override { return CommandId::ID_PaintMetatile; }
 
+    qint64 byteSize() const override { return delta.byteSize(); }
+    BlockdataDelta *getDelta() override { return &delta; }
+
+protected:
+    void releaseBlocks() override { delta = BlockdataDelta(); }
+
 private:
     Map *map;
 
-    Blockdata newMetatiles;
-    Blockdata oldMetatiles;
+    // Only the changed blocks are stored, see BlockdataDelta
+    BlockdataDelta delta;
 
     unsigned actionId;
 };
@@ -74,6 +111,11 @@ public:
     : PaintMetatile(map, oldCollision, newCollision, actionId, parent) {
         setText("Paint Collision");
     }
+    PaintCollision(Map *map, const BlockdataDelta &delta,
+        unsigned actionId, QUndoCommand *parent = nullptr)
+    : PaintMetatile(map, delta, actionId, parent) {
+        setText("Paint Collision");
+    }
 
     int id() const override { return CommandId::ID_PaintCollision; }
 };
@@ -81,7 +123,7 @@ public:
 
 
 /// Implements a command to commit paint actions on the map border.
-class PaintBorder : public QUndoCommand {
+class PaintBorder : public MapBlocksCommand {
 public:
     PaintBorder(Map *map,
         const Blockdata &oldBorder, const Blockdata &newBorder,
@@ -93,6 +135,11 @@ public:
     bool mergeWith(const QUndoCommand *) override { return false; };
     int id() const override { return CommandId::ID_PaintBorder; }
 
+    qint64 byteSize() const override;
+
+protected:
+    void releaseBlocks() override;
+
 private:
     Map *map;
 
@@ -147,6 +194,11 @@ public:
       : PaintMetatile(map, oldMetatiles, newMetatiles, actionId, parent) {
         setText("Magic Fill Metatiles");
     }
+    MagicFillMetatile(Map *map, const BlockdataDelta &delta,
+        unsigned actionId, QUndoCommand *parent = nullptr)
+      : PaintMetatile(map, delta, actionId, parent) {
+        setText("Magic Fill Metatiles");
+    }
 
     int id() const override { return CommandId::ID_MagicFillMetatile; }
 };
@@ -162,6 +214,11 @@ public:
     : PaintCollision(map, oldCollision, newCollision, -1, parent) {
         setText("Magic Fill Collision");
     }
+    MagicFillCollision(Map *map, const BlockdataDelta &delta,
+        QUndoCommand *parent = nullptr)
+    : PaintCollision(map, delta, -1, parent) {
+        setText("Magic Fill Collision");
+    }
 
     bool mergeWith(const QUndoCommand *) override { return false; }
     int id() const override { return CommandId::ID_MagicFillCollision; }
@@ -170,7 +227,7 @@ public:
 
 
 /// Implements a command to commit metatile shift actions.
-class ShiftMetatiles : public QUndoCommand {
+class ShiftMetatiles : public MapBlocksCommand {
 public:
     ShiftMetatiles(Map *map,
         const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
@@ -182,11 +239,16 @@ public:
     bool mergeWith(const QUndoCommand *command) override;
     int id() const override { return CommandId::ID_ShiftMetatiles; }
 
+    qint64 byteSize() const override { return delta.byteSize(); }
+    BlockdataDelta *getDelta() override { return &delta; }
+
+protected:
+    void releaseBlocks() override { delta = BlockdataDelta(); }
+
 private:
     Map *map;
 
-    Blockdata newMetatiles;
-    Blockdata oldMetatiles;
+    BlockdataDelta delta;
 
     unsigned actionId;
 };
@@ -194,7 +256,7 @@ private:
 
 
 /// Implements a command to commit a map or border resize action.
-class ResizeMap : public QUndoCommand {
+class ResizeMap : public MapBlocksCommand {
 public:
     ResizeMap(Map *map, QSize oldMapDimensions, QSize newMapDimensions,
         const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
@@ -208,6 +270,11 @@ public:
     bool mergeWith(const QUndoCommand *) override { return false; }
     int id() const override { return CommandId::ID_ResizeMap; }
 
+    qint64 byteSize() const override;
+
+protected:
+    void releaseBlocks() override;
+
 private:
     Map *map;
 
@@ -344,7 +411,7 @@ public:
 
 /// Implements a command to commit map edits from the scripting API.
 /// The scripting api can edit map/border blocks and dimensions.
-class ScriptEditMap : public QUndoCommand {
+class ScriptEditMap : public MapBlocksCommand {
 public:
     ScriptEditMap(Map *map,
         QSize oldMapDimensions, QSize newMapDimensions,
@@ -359,6 +426,11 @@ public:
     bool mergeWith(const QUndoCommand *) override { return false; }
     int id() const override { return CommandId::ID_ScriptEditMap; }
 
+    qint64 byteSize() const override;
+
+protected:
+    void releaseBlocks() override;
+
 private:
     Map *map;
 
@@ -66,6 +66,8 @@ public:
 
     QMap<Event::Group, QList<Event *>> events;
     QList<Event *> ownedEvents; // for memory management
+    bool eventsLoaded = true;
+    QJsonObject eventsJson; // The map's events before they're created by Project::loadMapEvents
 
     QList<MapConnection*> connections;
     QList<int> metatileLayerOrder;
@@ -78,19 +80,24 @@ public:
     int getBorderHeight();
     QPixmap render(bool ignoreCache = false, MapLayout *fromLayout = nullptr, QRect bounds = QRect(0, 0, -1, -1));
     QPixmap renderCollision(bool ignoreCache);
-    bool mapBlockChanged(int i, const Blockdata &cache);
     bool borderBlockChanged(int i, const Blockdata &cache);
-    void cacheBlockdata();
-    void cacheCollision();
+    void renderMetatiles(QImage *dest, const QRect &area, const QPoint &destOrigin = QPoint(), MapLayout *fromLayout = nullptr);
+    void renderCollisionMetatiles(QImage *dest, const QRect &area, const QPoint &destOrigin = QPoint());
+    void markDirty(const QRect &area);
+    void markAllDirty();
+    QRect takeDirtyMapItemArea();
+    QRect takeDirtyCollisionItemArea();
     bool getBlock(int x, int y, Block *out);
     void setBlock(int x, int y, Block block, bool enableScriptCallback = false);
     void setBlockdata(Blockdata blockdata, bool enableScriptCallback = false);
+    void applyBlockdataDelta(const BlockdataDelta &delta, bool undo, bool enableScriptCallback = false);
     uint16_t getBorderMetatileId(int x, int y);
     void setBorderMetatileId(int x, int y, uint16_t metatileId, bool enableScriptCallback = false);
     void setBorderBlockData(Blockdata blockdata, bool enableScriptCallback = false);
+    void setBlocks(const QVector<BlockUpdate> &updates, bool enableScriptCallback = false, BlockdataDelta *delta = nullptr);
+    QVector<int> getFloodFillArea(int x, int y, uint16_t mask);
     void floodFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation);
-    void _floodFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation);
-    void magicFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation);
+    void magicFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation, BlockdataDelta *delta = nullptr);
     QList<Event *> getAllEvents() const;
     QStringList eventScriptLabels(Event::Group group = Event::Group::None) const;
     void removeEvent(Event *);
@@ -120,6 +127,13 @@ public:
     void clean();
 
 private:
+    // The areas of the map (in metatiles) that changed since the map or collision image was last rendered
+    QRect dirtyMetatileArea;
+    QRect dirtyCollisionArea;
+    // The areas of the map (in metatiles) that changed since they were last taken by the map or collision item
+    QRect dirtyMapItemArea;
+    QRect dirtyCollisionItemArea;
+
     void setNewDimensionsBlockdata(int newWidth, int newHeight);
     void setNewBorderDimensionsBlockdata(int newWidth, int newHeight);
 
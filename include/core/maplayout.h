@@ -28,8 +28,6 @@ public:
     QImage border_image;
     QPixmap border_pixmap;
     Blockdata border;
-    Blockdata cached_blockdata;
-    Blockdata cached_collision;
     Blockdata cached_border;
     struct {
         Blockdata blocks;
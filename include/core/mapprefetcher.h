@@ -0,0 +1,50 @@
+#pragma once
+#ifndef MAPPREFETCHER_H
+#define MAPPREFETCHER_H
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class Map;
+class MapLayout;
+class Project;
+
+// Loads the maps that are likely to be opened next (the open map's connections and warp destinations)
+// while the application is idle, so that switching to them is instant.
+// The maps are prefetched one at a time. A map's files are read and its tilesets are decoded on worker threads,
+// then the map is built on the main thread and its metatile images are rendered into its tileset's cache.
+// Prefetching stops once the prefetched maps and the tilesets decoded for them use more than the configured
+// memory budget, or when a different map is opened.
+class MapPrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MapPrefetcher(Project *project);
+
+    // Cancels any prefetching for the previous map.
+    void prefetchNeighbors(Map *map);
+    void cancel();
+
+private:
+    struct PendingMap {
+        QString name;
+        // Set once the map's map.json has been read
+        MapLayout *layout = nullptr;
+        bool readStarted = false;
+        // The tilesets that weren't loaded before this map was prefetched, which count towards the budget
+        QStringList newTilesetLabels;
+    };
+    Project *project;
+    QList<PendingMap> queue;
+    QTimer timer;
+    qint64 usedBytes = 0;
+    qint64 budgetBytes = 0;
+
+    void prefetchNext();
+    void scheduleNext();
+    static qint64 renderMetatileImages(Map *map);
+};
+
+#endif // MAPPREFETCHER_H
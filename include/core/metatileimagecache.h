@@ -0,0 +1,61 @@
+#pragma once
+#ifndef METATILEIMAGECACHE_H
+#define METATILEIMAGECACHE_H
+
+#include "metatile.h"
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QRgb>
+
+class Tileset;
+
+// Stores the composited 16x16 images of a tileset pair's metatiles, so that rendering
+// a map only has to composite each distinct metatile once.
+// The cache is owned by the secondary tileset of the pair it was built for. Rather than
+// relying on every edit to notify it, the cache keeps (implicitly shared) copies of the
+// data that its images were built from, and compares them on use. Unchanged data shares
+// storage with the tileset, so these comparisons are cheap unless something was edited.
+class MetatileImageCache
+{
+public:
+    MetatileImageCache() = default;
+
+    // Drops all cached images if the tilesets' palettes or tile images, or the given layer settings,
+    // differ from the ones the cache was built with.
+    void validate(const Tileset *primaryTileset, const Tileset *secondaryTileset,
+                  const QList<int> &layerOrder, const QList<float> &layerOpacity);
+
+    // Returns a null image if there is no valid cached image for this metatile.
+    QImage find(uint16_t metatileId, const Metatile *metatile, bool useTruePalettes) const;
+    void insert(uint16_t metatileId, const Metatile *metatile, bool useTruePalettes, const QImage &image);
+    void clear();
+    int size() const { return entries.size(); }
+
+private:
+    struct Entry {
+        QList<Tile> tiles;
+        uint32_t layerType;
+        QImage image;
+    };
+    QHash<uint32_t, Entry> entries;
+
+    // The state that the cached images were built from
+    const Tileset *primaryTileset = nullptr;
+    QByteArray primaryTilePixels;
+    QByteArray secondaryTilePixels;
+    QList<QList<QRgb>> primaryPalettes;
+    QList<QList<QRgb>> secondaryPalettes;
+    QList<QList<QRgb>> primaryPalettePreviews;
+    QList<QList<QRgb>> secondaryPalettePreviews;
+    QList<int> layerOrder;
+    QList<float> layerOpacity;
+    bool tripleLayerMetatiles = false;
+
+    static uint32_t getKey(uint16_t metatileId, bool useTruePalettes) {
+        return metatileId | (static_cast<uint32_t>(useTruePalettes) << 16);
+    }
+};
+
+#endif // METATILEIMAGECACHE_H
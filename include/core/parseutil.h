@@ -5,47 +5,28 @@
 #include "heallocation.h"
 #include "log.h"
 #include "orderedjson.h"
+#include "projectcache.h"
 
+#include <QDateTime>
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QMap>
+#include <QVector>
 #include <QRegularExpression>
 
 
 
-enum TokenClass {
-    Number,
-    Operator,
-    Error,
-};
-
-class Token {
-public:
-    Token(QString value = "", QString type = "") {
-        this->value = value;
-        this->type = TokenClass::Operator;
-        if (type == "decimal" || type == "hex") {
-            this->type = TokenClass::Number;
-            this->operatorPrecedence = -1;
-        } else if (type == "operator") {
-            this->operatorPrecedence = precedenceMap[value];
-        } else if (type == "error") {
-            this->type = TokenClass::Error;
-        }
-    }
-    static QMap<QString, int> precedenceMap;
-    QString value;
-    TokenClass type;
-    int operatorPrecedence; // only relevant for operator tokens
-};
-
 class ParseUtil
 {
 public:
     ParseUtil();
     void set_root(const QString &dir);
+    void setCache(ProjectCache *cache);
+    // Text files are cached until they change on disk, or until they're invalidated.
     static QString readTextFile(const QString &path);
-    void invalidateTextFile(const QString &path);
+    static void invalidateTextFile(const QString &path);
+    static void clearTextFileCache();
     static int textFileLineCount(const QString &path);
     QList<QStringList> parseAsm(const QString &filename);
     int evaluateDefine(const QString&, const QMap<QString, int>&);
@@ -55,7 +36,8 @@ public:
     QString readCIncbin(const QString &text, const QString &label);
     QMap<QString, QString> readCIncbinMulti(const QString &filepath);
     QStringList readCIncbinArray(const QString &filename, const QString &label);
-    QMap<QString, int> readCDefines(const QString &filename, const QStringList &prefixes, QMap<QString, int> = { });
+    QMap<QString, QStringList> readCIncbinArrayMulti(const QString &filename);
+    QMap<QString, int> readCDefines(const QString &filename, const QStringList &prefixes, const QMap<QString, int> &knownDefines = { });
     QStringList readCDefinesSorted(const QString&, const QStringList&, const QMap<QString, int>& = { });
     QMap<QString, QHash<QString, QString>> readCStructs(const QString &, const QString & = "", const QHash<int, QString> = { });
     QList<QStringList> getLabelMacros(const QList<QStringList>&, const QString&);
@@ -89,13 +71,43 @@ private:
     QString file;
     QString curDefine;
     QHash<QString, QStringList> errorMap;
-    QList<Token> tokenizeExpression(QString expression, const QMap<QString, int> &knownIdentifiers);
-    QList<Token> generatePostfix(const QList<Token> &tokens);
-    int evaluatePostfix(const QList<Token> &postfix);
+    ProjectCache *cache = nullptr;
+    bool loggedParseErrors = false;
+
+    // The defines whose values are known when evaluating an expression.
+    // Defines read from the current file are interned as indexes into a flat table of values,
+    // and any other defines are looked up in knownDefines.
+    struct DefineTable {
+        const QMap<QString, int> *knownDefines = nullptr;
+        QHash<QString, int> ids;
+        QVector<int> values;
+        void insert(const QString &name, int value);
+    };
+    QVector<int> compileExpression(const QString &expression, const DefineTable &table);
+    int evaluateExpression(const QVector<int> &code, const DefineTable &table);
     void recordError(const QString &message);
     void recordErrors(const QStringList &errors);
     void logRecordedErrors();
     QString createErrorMessage(const QString &message, const QString &expression);
+    static QList<QPair<QString, QString>> scanCDefines(const QString &text, QString *strippedText);
+
+    // Indexes of the values of every label in a file, so that looking up single labels doesn't scan the file again
+    enum class LabelIndex {
+        CArrays,
+        CIncbins,
+        CIncbinArrays,
+    };
+    struct LabelIndexEntry {
+        bool isValid = false;
+        qint64 size = 0;
+        QDateTime lastModified;
+        QMap<QString, QStringList> values;
+    };
+    QHash<QPair<int, QString>, LabelIndexEntry> labelIndexes;
+    const QMap<QString, QStringList> &getLabelIndex(const QString &filename, LabelIndex type);
+
+    template <typename T> bool findCachedResult(const QString &filepath, const QString &key, T *out);
+    template <typename T> void cacheResult(const QString &filepath, const QString &key, const T &result);
 
     static const QRegularExpression re_incScriptLabel;
     static const QRegularExpression re_globalIncScriptLabel;
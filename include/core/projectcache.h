@@ -0,0 +1,52 @@
+#pragma once
+#ifndef PROJECTCACHE_H
+#define PROJECTCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Persists the results of parsing project files between sessions, so that reopening a project
+// only has to re-parse the files that changed since it was last opened.
+// Results are stored per source file, along with the file's size, modification time and
+// content hash. If the size or modification time changed the hash is checked, so files that
+// were only touched (e.g. rebuilt with the same contents) don't need to be parsed again.
+// The cache may be used from multiple threads.
+class ProjectCache
+{
+public:
+    ProjectCache() = default;
+
+    // Loads the cache for the project at the given root, discarding the current contents.
+    void load(const QString &root);
+    // Writes the cache to disk if it was changed.
+    void save();
+    void clear();
+
+    // Returns true and sets 'out' if there is a result for the key that was
+    // parsed from the current version of the file at 'filepath'.
+    bool find(const QString &filepath, const QString &key, QByteArray *out);
+    void insert(const QString &filepath, const QString &key, const QByteArray &data);
+
+private:
+    struct FileSignature {
+        qint64 size = -1;
+        qint64 lastModified = 0;
+        QByteArray hash;
+    };
+    struct FileEntry {
+        FileSignature signature;
+        QHash<QString, QByteArray> results;
+    };
+    QHash<QString, FileEntry> files;
+    QString cacheFilepath;
+    bool modified = false;
+    QMutex mutex;
+
+    static QString getCacheFilepath(const QString &root);
+    static bool readSignature(const QString &filepath, FileSignature *signature, bool computeHash);
+    bool validate(const QString &filepath);
+};
+
+#endif // PROJECTCACHE_H
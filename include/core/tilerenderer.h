@@ -0,0 +1,38 @@
+#pragma once
+#ifndef TILERENDERER_H
+#define TILERENDERER_H
+
+#include <cstdint>
+#include <cstring>
+
+// Low-level routines for writing tile and metatile pixels directly into RGBA8888 image data.
+// Destination pointers address the top-left pixel to write, and strides are in bytes
+// (i.e. QImage::bytesPerLine() for the destination image).
+namespace TileRenderer {
+    // Converts a 0xAARRGGBB color (QRgb) to a pixel value with the byte order of QImage::Format_RGBA8888.
+    inline uint32_t toRgba8888(uint32_t argb, uint8_t alpha = 255) {
+        const uint8_t bytes[4] = {
+            static_cast<uint8_t>((argb >> 16) & 0xFF),
+            static_cast<uint8_t>((argb >> 8) & 0xFF),
+            static_cast<uint8_t>(argb & 0xFF),
+            alpha,
+        };
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // Draws an 8x8 tile of palette indices (64 bytes, row-major) using a 16-color palette of
+    // RGBA8888 pixel values. If transparentColor0 is set, pixels using color 0 are left untouched.
+    // Pixels are drawn opaque if alpha is 255, otherwise they're blended over the existing (opaque) pixels.
+    void drawTile(uint8_t *dest, int destStride, const uint8_t *tilePixels, const uint32_t *palette,
+                  bool xflip, bool yflip, bool transparentColor0, int alpha = 255);
+
+    // Fills an 8x8 area with a single RGBA8888 pixel value.
+    void fillTile(uint8_t *dest, int destStride, uint32_t color);
+
+    // Copies a block of RGBA8888 pixels, e.g. a rendered metatile, into another image.
+    void blit(uint8_t *dest, int destStride, const uint8_t *src, int srcStride, int width, int height);
+}
+
+#endif // TILERENDERER_H
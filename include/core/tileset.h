@@ -3,7 +3,9 @@
 #define TILESET_H
 
 #include "metatile.h"
+#include "metatileimagecache.h"
 #include "tile.h"
+#include <QByteArray>
 #include <QImage>
 #include <QHash>
 
@@ -32,7 +34,9 @@ public:
     QImage tilesImage;
     QStringList palettePaths;
 
-    QList<QImage> tiles;
+    // Palette indices for the pixels of every tile in the tiles image, one byte per pixel.
+    // Each tile's pixels are stored contiguously in row-major order, so a tile is just an offset into this buffer.
+    QByteArray tilePixels;
     QList<Metatile*> metatiles;
     QHash<int, QString> metatileLabels;
     QList<QList<QRgb>> palettes;
@@ -40,15 +44,27 @@ public:
 
     bool hasUnsavedTilesImage;
 
+    static const int tileWidth = 8;
+    static const int tileHeight = 8;
+    static const int pixelsPerTile = tileWidth * tileHeight;
+
+    // Composited images of the metatiles rendered with this as the secondary tileset.
+    // Not copied with the tileset.
+    MetatileImageCache metatileImageCache;
+
     static Tileset* getMetatileTileset(int, Tileset*, Tileset*);
     static Tileset* getTileTileset(int, Tileset*, Tileset*);
     static Metatile* getMetatile(int, Tileset*, Tileset*);
+    static const uchar* getTilePixels(int, Tileset*, Tileset*);
     static Tileset* getMetatileLabelTileset(int, Tileset*, Tileset*);
     static QString getMetatileLabel(int, Tileset *, Tileset *);
     static QString getOwnedMetatileLabel(int, Tileset *, Tileset *);
     static MetatileLabelPair getMetatileLabelPair(int metatileId, Tileset *primaryTileset, Tileset *secondaryTileset);
     static bool setMetatileLabel(int, QString, Tileset *, Tileset *);
     QString getMetatileLabelPrefix();
+    int numTiles() const { return this->tilePixels.size() / pixelsPerTile; }
+    const uchar* getTilePixels(int index) const;
+    void setTilePixels(const QImage &image);
     static QString getMetatileLabelPrefix(const QString &name);
     static QList<QList<QRgb>> getBlockPalettes(Tileset*, Tileset*, bool useTruePalettes = false);
     static QList<QRgb> getPalette(int, Tileset*, Tileset*, bool useTruePalettes = false);
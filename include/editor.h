@@ -108,6 +108,8 @@ public:
     MapPixmapItem *map_item = nullptr;
     ConnectionPixmapItem* selected_connection_item = nullptr;
     QList<ConnectionPixmapItem*> connection_items;
+    // Connections whose maps' tilesets were still loading when the map was displayed (see displayPendingConnections)
+    QList<MapConnection*> pending_connections;
     QGraphicsPathItem *connection_mask = nullptr;
     CollisionPixmapItem *collision_item = nullptr;
     QGraphicsItemGroup *events_group = nullptr;
@@ -154,6 +156,7 @@ public slots:
     void openScript(const QString &scriptLabel) const;
     void openProjectInTextEditor() const;
     void maskNonVisibleConnectionTiles();
+    void displayPendingConnections();
     void onBorderMetatilesChanged();
     void selectedEventIndexChanged(int index, Event::Group eventGroup);
 
@@ -0,0 +1,41 @@
+#pragma once
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+class Map;
+class Project;
+
+// Runs porymap without a window, for use in batch pipelines and CI:
+//     porymap --headless <project> <command> [arguments...]
+// The project is opened the same way as in the editor, but nothing that requires a window
+// (e.g. asking the user to reload changed files) is done. See printUsage for the commands.
+class HeadlessRunner
+{
+public:
+    // Returns true if the command line asks for headless mode. Must be checked before the application
+    // is created, so that the offscreen platform can be used when there's no display (see main).
+    static bool isRequested(int argc, char *argv[]);
+
+    // Returns the process exit code.
+    int run(const QStringList &arguments);
+
+private:
+    Project *project = nullptr;
+    bool drawEvents = false;
+
+    bool openProject(const QString &dir);
+    int exportMapImage(const QStringList &args);
+    int exportStitchedMapImage(const QStringList &args);
+    int resaveAll();
+    int runScript(const QStringList &args);
+
+    QImage renderMap(Map *map);
+    Map *getMap(const QString &mapName);
+    static void printUsage();
+};
+
+#endif // HEADLESSRUNNER_H
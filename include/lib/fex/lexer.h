@@ -90,7 +90,7 @@ namespace fex
         ~Lexer() = default;
 
         std::vector<Token> LexFile(const std::string &path);
-        std::vector<Token> LexString(const std::string &data);
+        std::vector<Token> LexString(const std::string &data, const std::string &filename = "string literal");
         void LexFileDumpTokens(const std::string &path, const std::string &out);
 
     private:
@@ -49,6 +49,7 @@ public:
     // Scripting API
     Q_INVOKABLE QJSValue getBlock(int x, int y);
     void tryRedrawMapArea(bool forceRedraw);
+    void flushMapRedraw();
     void tryCommitMapChanges(bool commitChanges);
     Q_INVOKABLE void setBlock(int x, int y, int metatileId, int collision, int elevation, bool forceRedraw = true, bool commitChanges = true);
     Q_INVOKABLE void setBlock(int x, int y, int rawValue, bool forceRedraw = true, bool commitChanges = true);
@@ -66,6 +67,8 @@ public:
     Q_INVOKABLE void magicFill(int x, int y, int metatileId, bool forceRedraw = true, bool commitChanges = true);
     Q_INVOKABLE void magicFillFromSelection(int x, int y, bool forceRedraw = true, bool commitChanges = true);
     Q_INVOKABLE void shift(int xDelta, int yDelta, bool forceRedraw = true, bool commitChanges = true);
+    Q_INVOKABLE QJSValue getBlockdata(int x = 0, int y = 0, int width = -1, int height = -1);
+    Q_INVOKABLE void setBlockdata(int x, int y, int width, int height, QJSValue rawValues, bool forceRedraw = true, bool commitChanges = true);
     Q_INVOKABLE void redraw();
     Q_INVOKABLE void commit();
     Q_INVOKABLE QJSValue getDimensions();
@@ -163,6 +166,7 @@ public slots:
 private slots:
     void on_action_Open_Project_triggered();
     void on_action_Reload_Project_triggered();
+    void onProjectDataReloaded();
     void on_mapList_activated(const QModelIndex &index);
     void on_action_Save_Project_triggered();
     void openWarpMap(QString map_name, int event_id, Event::Group event_group);
@@ -334,8 +338,11 @@ private:
     MapSortOrder mapSortOrder;
 
     bool tilesetNeedsRedraw = false;
+    bool mapRedrawPending = false;
+    void redrawMapArea();
 
     bool setMap(QString, bool scrollTreeView = false);
+    void trimMapCache();
     void redrawMapScene();
     void refreshMapScene();
     bool loadDataStructures();
@@ -9,6 +9,7 @@
 #include "parseutil.h"
 #include "orderedjson.h"
 #include "regionmap.h"
+#include "mapprefetcher.h"
 
 #include <QStringList>
 #include <QList>
@@ -17,6 +18,12 @@
 #include <QStandardItem>
 #include <QVariant>
 #include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSet>
+
+#include <functional>
 
 struct EventGraphics
 {
@@ -26,6 +33,14 @@ struct EventGraphics
     bool inanimate;
 };
 
+// A map and its position in metatiles relative to the first map, in an image of maps stitched together by their connections
+struct StitchedMap
+{
+    int x;
+    int y;
+    Map *map;
+};
+
 // The constant and displayed name of the special map value used by warps with multiple potential destinations
 static QString DYNAMIC_MAP_CONSTANT = "MAP_DYNAMIC";
 static QString DYNAMIC_MAP_NAME = "Dynamic";
@@ -81,6 +96,7 @@ public:
     QMap<int, QString> metatileBehaviorMapInverse;
     QMap<QString, QString> facingDirections;
     ParseUtil parser;
+    ProjectCache cache;
     QFileSystemWatcher fileWatcher;
     QMap<QString, qint64> modifiedFileTimestamps;
     bool usingAsmTilesets;
@@ -110,6 +126,21 @@ public:
     QMap<QString, Tileset*> tilesetCache;
     Tileset* loadTileset(QString, Tileset *tileset = nullptr);
     Tileset* getTileset(QString, bool forceLoad = false);
+    void prefetchTileset(const QString &label);
+    void prefetchConnectedTilesets(Map *map);
+    bool isTilesetLoading(const QString &label) const { return pendingTilesets.contains(label); }
+    bool isMapWaitingForTilesets(const QString &mapName) const;
+    void prefetchMapJson(const QString &mapName);
+    bool isMapJsonLoading(const QString &mapName) const { return pendingMapJson.contains(mapName); }
+    MapLayout *getPrefetchedMapLayout(const QString &mapName) const;
+    void prefetchLayoutBlockdata(MapLayout *layout);
+    bool isLayoutBlockdataLoading(const MapLayout *layout) const;
+    MapPrefetcher *mapPrefetcher;
+    void trimCaches(const QSet<Map*> &keepMaps);
+    void trimCachesKeeping(const QList<Map*> &maps);
+    QList<StitchedMap> getStitchedMaps(Map *startMap, const std::function<bool(int, int)> &onProgress = nullptr);
+    static QRect getStitchedBounds(const QList<StitchedMap> &stitchedMaps);
+    static qint64 getTilesetBytes(const Tileset *tileset);
     QStringList primaryTilesetLabels;
     QStringList secondaryTilesetLabels;
     QStringList tilesetLabelsOrdered;
@@ -122,6 +153,7 @@ public:
     void appendTextFile(QString path, QString text);
     void deleteFile(QString path);
 
+    bool readDataStructures();
     bool readMapGroups();
     Map* addNewMapToGroup(QString, int, Map*, bool, bool);
     QString getNewMapName();
@@ -142,6 +174,7 @@ public:
 
     QSet<QString> getTopLevelMapFields();
     bool loadMapData(Map*);
+    void loadMapEvents(Map*);
     bool readMapLayouts();
     bool loadLayout(MapLayout *);
     bool loadMapLayout(Map*);
@@ -198,6 +231,13 @@ public:
     bool readEventScriptLabels();
     bool readObjEventGfxConstants();
     bool readSongNames();
+
+    // The functions that read the project's data when it's opened, grouped into chains.
+    // Each reader may use data from the readers before it in its chain, but not from other chains.
+    typedef bool (Project::*DataReader)();
+    static const QList<QList<DataReader>> &getDataReaderChains();
+    bool runDataReader(DataReader reader);
+    bool reloadChangedFiles(const QStringList &filepaths);
     bool readEventGraphics();
     QMap<QString, QMap<QString, QString>> readObjEventGfxInfo();
 
@@ -245,6 +285,45 @@ private:
     void saveHealLocationsConstants();
 
     void ignoreWatchedFileTemporarily(QString filepath);
+    QHash<QString, QList<DataReader>> fileReaders;
+    QMutex fileReadersMutex;
+    QSet<QString> changedFiles;
+    void watchFile(const QString &filepath);
+    void watchFiles(const QStringList &filepaths);
+    ParseUtil &threadParser();
+
+    // Tilesets being loaded in the background (see prefetchTileset). They're added to the tileset cache once they finish.
+    QHash<QString, QFutureWatcher<Tileset*>*> pendingTilesets;
+    Tileset* readTileset(const QString &label, Tileset *tileset);
+    void publishPendingTileset(const QString &label);
+    void publishPendingTilesets();
+
+    // The map.json contents of maps that were read before the maps were loaded (e.g. to prefetch their tilesets).
+    // They're used when the map is loaded, so each map.json is only read once.
+    QHash<QString, QJsonObject> prefetchedMapJson;
+    QHash<QString, QFutureWatcher<QJsonObject>*> pendingMapJson;
+    bool readMapJson(const QString &mapName, QJsonObject *mapObj);
+    void publishPendingMapJson(const QString &mapName);
+
+    // Blockdata files read on a worker thread before their layout was loaded (see prefetchLayoutBlockdata), by path.
+    QHash<QString, Blockdata> prefetchedBlockdata;
+    QHash<QString, QFutureWatcher<Blockdata>*> pendingBlockdata;
+    static Blockdata readBlockdataFile(const QString &path);
+    void publishPendingBlockdata(const QString &path);
+    void clearPrefetchedMapFiles();
+
+    // When each cached map and tileset was last requested, for evicting the least recently used ones (see trimCaches).
+    QHash<QString, quint64> mapLastUsed;
+    QHash<QString, quint64> tilesetLastUsed;
+    quint64 cacheUseCounter = 0;
+    int numEvictedMaps = 0;
+    int numEvictedTilesets = 0;
+    bool canEvictMap(Map *map, const QSet<Map*> &keepMaps);
+    qint64 releaseRenderBuffers(Map *map);
+    qint64 evictMap(Map *map, const QSet<Map*> &keepMaps);
+    qint64 evictTileset(const QString &label);
+    static qint64 getRenderBufferBytes(const Map *map);
+    static qint64 getLayoutBytes(const MapLayout *layout);
 
     static int num_tiles_primary;
     static int num_tiles_total;
@@ -263,7 +342,9 @@ signals:
     void reloadProject();
     void uncheckMonitorFilesAction();
     void mapCacheCleared();
+    void tilesetLoaded(const QString &label);
     void disableWildEncountersUI();
+    void dataReloaded();
 };
 
 #endif // PROJECT_H
@@ -8,11 +8,13 @@
 
 #include <QStringList>
 #include <QJSEngine>
+#include <QSet>
 
 enum CallbackType {
     OnProjectOpened,
     OnProjectClosed,
     OnBlockChanged,
+    OnBlocksChanged,
     OnBorderMetatileChanged,
     OnBlockHoverChanged,
     OnBlockHoverCleared,
@@ -37,6 +39,8 @@ public:
     static void cb_ProjectOpened(QString projectPath);
     static void cb_ProjectClosed(QString projectPath);
     static void cb_MetatileChanged(int x, int y, Block prevBlock, Block newBlock);
+    static void beginBlockChangeBatch();
+    static void endBlockChangeBatch();
     static void cb_BorderMetatileChanged(int x, int y, uint16_t prevMetatileId, uint16_t newMetatileId);
     static void cb_BlockHoverChanged(int x, int y);
     static void cb_BlockHoverCleared();
@@ -49,7 +53,12 @@ public:
     static void cb_MapViewTabChanged(int oldTab, int newTab);
     static void cb_BorderVisibilityToggled(bool visible);
     static bool tryErrorJS(QJSValue js);
+    static QString getErrorMessage(QJSValue js);
     static QJSValue fromBlock(Block block);
+    static QJSValue toUint16Array(const QVector<uint16_t> &values);
+    static QJSValue toUint16Array(QJSEngine *engine, const QVector<uint16_t> &values);
+    static bool fromUint16Array(QJSValue array, QVector<uint16_t> *out);
+    static bool isValidBlockdataArea(int x, int y, int width, int height);
     static QJSValue fromTile(Tile tile);
     static Tile toTile(QJSValue obj);
     static QJSValue version(QList<int> versionNums);
@@ -65,9 +74,30 @@ private:
     QList<QJSValue> modules;
     QMap<QString, const QImage*> imageCache;
     ScriptUtility *scriptUtility;
+    QSet<CallbackType> registeredCallbacks;
+
+    struct BlockChange {
+        int x;
+        int y;
+        Block prevBlock;
+        Block newBlock;
+    };
+    QList<BlockChange> pendingBlockChanges;
+    int blockChangeBatchDepth = 0;
+    int callDepth = 0;
 
     void loadModules(QStringList moduleFiles);
     void invokeCallback(CallbackType type, QJSValueList args);
+    void invokeBlockChangeCallbacks(const QList<BlockChange> &changes);
+};
+
+// Collects the block changes made while it exists (e.g. during one edit action), so that scripts
+// are notified of all of them together once the outermost batch ends.
+class ScriptBlockChangeBatch
+{
+public:
+    ScriptBlockChangeBatch() { Scripting::beginBlockChangeBatch(); }
+    ~ScriptBlockChangeBatch() { Scripting::endBlockChangeBatch(); }
 };
 
 #endif // SCRIPTING_H
@@ -4,6 +4,8 @@
 
 #include "mainwindow.h"
 
+class ScriptWorker;
+
 class ScriptUtility : public QObject
 {
     Q_OBJECT
@@ -11,6 +13,7 @@ class ScriptUtility : public QObject
 public:
     ScriptUtility(MainWindow *mainWindow);
     void clearActions();
+    void stopWorkers();
     QString getActionFunctionName(int actionIndex);
     Q_INVOKABLE bool registerAction(QString functionName, QString actionName, QString shortcut = "");
     Q_INVOKABLE bool registerToggleAction(QString functionName, QString actionName, QString shortcut = "", bool checked = false);
@@ -52,14 +55,19 @@ public:
     Q_INVOKABLE QList<QString> getBattleSceneNames();
     Q_INVOKABLE bool isPrimaryTileset(QString tilesetName);
     Q_INVOKABLE bool isSecondaryTileset(QString tilesetName);
+    Q_INVOKABLE int startWorker(QString filepath, QString functionName, QList<QString> mapNames = QList<QString>(), QJSValue args = QJSValue(), QJSValue onFinished = QJSValue(), QJSValue onProgress = QJSValue());
+    Q_INVOKABLE void cancelWorker(int workerId);
 
 private:
     void callTimeoutFunction(QJSValue callback);
     void runMessageBox(QString text, QString informativeText, QString detailedText, QMessageBox::Icon icon);
+    void finishWorker(int workerId, QJSValue onFinished);
 
     MainWindow *window;
     QList<QAction *> registeredActions;
     QHash<int, QString> actionMap;
+    QHash<int, ScriptWorker*> workers;
+    int nextWorkerId = 0;
 };
 
 #endif // SCRIPTUTILITY_H
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef SCRIPTWORKER_H
+#define SCRIPTWORKER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJSValue>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+#include <QVector>
+
+class Map;
+class Project;
+class QJSEngine;
+
+// Runs a function exported by a script file in its own QJSEngine on a separate thread, so that
+// long-running scripts (e.g. generators or validators that visit every map) don't block the editor.
+// The script can only see a snapshot of the maps it was given, taken when the job was started,
+// and its edits to them are only applied to the project once it finishes (see applyChanges).
+// Scripts access the snapshot through the 'worker' global object (see ScriptWorkerApi).
+class ScriptWorker : public QThread
+{
+    Q_OBJECT
+public:
+    struct MapSnapshot {
+        int width = 0;
+        int height = 0;
+        QVector<uint16_t> originalBlocks;
+        QVector<uint16_t> blocks;
+        // Indexed by metatile id. -1 for metatile ids with no metatile.
+        QVector<int> metatileAttributes;
+        QVector<int> metatileBehaviors;
+    };
+
+    ScriptWorker(const QString &filepath, const QString &functionName, const QVariant &args, const QString &projectRoot);
+
+    // Must be called before the worker is started.
+    void addMap(Map *map);
+
+    // Stops the script as soon as possible. Its edits are discarded.
+    void cancel();
+    bool isCanceled() const { return this->canceled.loadRelaxed(); }
+
+    // Only valid once the worker has finished.
+    QString getError() const { return this->error; }
+    QVariant getResult() const { return this->result; }
+    QStringList getChangedMapNames() const;
+
+    // Applies the script's edits to the project's maps, as one undoable edit per map.
+    // Blocks the script didn't change keep any edits that were made while it was running.
+    // Returns the names of the maps that were changed.
+    QStringList applyChanges(Project *project, Map *currentMap);
+
+    QString getProjectRoot() const { return this->projectRoot; }
+
+signals:
+    void progressChanged(double progress, QString message);
+
+protected:
+    void run() override;
+
+private:
+    friend class ScriptWorkerApi;
+
+    QString filepath;
+    QString functionName;
+    QVariant args;
+    QString projectRoot;
+    QStringList mapNames;
+    QHash<QString, MapSnapshot> maps;
+    QHash<QString, QPair<QVector<int>, QVector<int>>> tilesetAttributes;
+    QSet<QString> changedMapNames;
+
+    QAtomicInt canceled;
+    QMutex engineMutex;
+    QJSEngine *engine = nullptr;
+
+    QString error;
+    QVariant result;
+    QElapsedTimer progressTimer;
+
+    void reportProgress(double progress, const QString &message);
+};
+
+// The 'worker' global object of a ScriptWorker's engine. Lives on the worker's thread.
+class ScriptWorkerApi : public QObject
+{
+    Q_OBJECT
+public:
+    ScriptWorkerApi(ScriptWorker *worker, QJSEngine *engine);
+
+    Q_INVOKABLE QList<QString> getMapNames();
+    Q_INVOKABLE QJSValue getDimensions(QString mapName);
+    Q_INVOKABLE QJSValue getBlockdata(QString mapName, int x = 0, int y = 0, int width = -1, int height = -1);
+    Q_INVOKABLE void setBlockdata(QString mapName, int x, int y, int width, int height, QJSValue rawValues);
+    Q_INVOKABLE int getMetatileAttributes(QString mapName, int metatileId);
+    Q_INVOKABLE int getMetatileBehavior(QString mapName, int metatileId);
+    Q_INVOKABLE void setProgress(double progress, QString message = "");
+    Q_INVOKABLE bool isCanceled();
+    Q_INVOKABLE void log(QString message);
+
+private:
+    ScriptWorker *worker;
+    QJSEngine *engine;
+
+    ScriptWorker::MapSnapshot *getMap(const QString &mapName);
+};
+
+#endif // SCRIPTWORKER_H
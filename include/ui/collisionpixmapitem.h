@@ -9,6 +9,10 @@
 
 class CollisionPixmapItem : public MapPixmapItem {
     Q_OBJECT
+
+private:
+    using MapPixmapItem::paint;
+
 public:
     CollisionPixmapItem(Map *map, MovementPermissionsSelector *movementPermissionsSelector, MetatileSelector *metatileSelector, Settings *settings, qreal *opacity)
         : MapPixmapItem(map, metatileSelector, settings){
@@ -25,6 +29,9 @@ public:
     virtual void pick(QGraphicsSceneMouseEvent*);
     void draw(bool ignoreCache = false);
 
+protected:
+    void renderChunk(QImage *image, const QRect &area) override;
+
 private:
     unsigned actionId_ = 0;
     QPoint previousPos;
@@ -14,6 +14,7 @@ QImage getTileImage(uint16_t, Tileset*, Tileset*);
 QImage getPalettedTileImage(uint16_t, Tileset*, Tileset*, int, bool useTruePalettes = false);
 QImage getGreyscaleTileImage(uint16_t tile, Tileset *primaryTileset, Tileset *secondaryTileset);
 void flattenTo4bppImage(QImage * image);
+void drawMetatileImage(QImage *dest, const QPoint &origin, const QImage &metatileImage);
 
 static QList<QRgb> greyscalePalette({
     qRgb(0, 0, 0),
@@ -0,0 +1,60 @@
+#ifndef MAPCHUNKCACHE_H
+#define MAPCHUNKCACHE_H
+
+#include <QHash>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+#include <functional>
+
+class QPainter;
+
+// Stores a map's rendered image as a grid of fixed-size chunks, rather than one pixmap of the whole map.
+// Chunks are only rendered once they're painted (i.e. once they're visible in a view), and chunks that
+// haven't been painted recently are discarded once the cache grows past its memory limit.
+// All areas given to and from the cache are in metatiles, unless noted otherwise.
+class MapChunkCache
+{
+public:
+    // Renders the given area of the map into an image whose top-left pixel is the top-left metatile of the area.
+    typedef std::function<void(QImage *image, const QRect &area)> RenderFunc;
+
+    static const int chunkSize = 32;
+    static const qint64 defaultMaxBytes = 64 * 1024 * 1024;
+
+    MapChunkCache(RenderFunc renderFunc, qint64 maxBytes = defaultMaxBytes);
+
+    // Resizing the map discards all chunks.
+    void setMapSize(const QSize &size);
+    QSize getMapSize() const { return mapSize; }
+
+    // Chunks overlapping the area are redrawn the next time they're painted.
+    void invalidate(const QRect &area);
+    void invalidateAll();
+    void clear();
+
+    // Draws the chunks that overlap the exposed area (in pixels), rendering them first if necessary.
+    void paint(QPainter *painter, const QRectF &exposedRect);
+
+private:
+    struct Chunk {
+        QPixmap pixmap;
+        QRect dirtyArea;
+        quint64 lastUsed = 0;
+    };
+    QHash<quint32, Chunk> chunks;
+    RenderFunc renderFunc;
+    QSize mapSize;
+    qint64 maxBytes;
+    qint64 totalBytes = 0;
+    quint64 useCounter = 0;
+
+    static quint32 getKey(int chunkX, int chunkY) {
+        return (static_cast<quint32>(chunkX) << 16) | static_cast<quint32>(chunkY);
+    }
+    QRect getChunkArea(int chunkX, int chunkY) const;
+    void updateChunk(Chunk *chunk, const QRect &chunkArea);
+    void evict(quint64 keepUsedSince);
+};
+
+#endif // MAPCHUNKCACHE_H
@@ -24,6 +24,8 @@ public:
     explicit MapImageExporter(QWidget *parent, Editor *editor, ImageExporterMode mode);
     ~MapImageExporter();
 
+    Map *getMap() const { return this->map; }
+
 private:
     Ui::MapImageExporter *ui;
 
@@ -4,21 +4,20 @@
 #include "map.h"
 #include "settings.h"
 #include "metatileselector.h"
+#include "mapchunkcache.h"
 #include <QGraphicsPixmapItem>
 
 class MapPixmapItem : public QObject, public QGraphicsPixmapItem {
     Q_OBJECT
 
-private:
-    using QGraphicsPixmapItem::paint;
-
 public:
     enum class PaintMode {
         Disabled,
         Metatiles,
         EventObjects
     };
-    MapPixmapItem(Map *map_, MetatileSelector *metatileSelector, Settings *settings) {
+    MapPixmapItem(Map *map_, MetatileSelector *metatileSelector, Settings *settings)
+        : chunks([this](QImage *image, const QRect &area) { this->renderChunk(image, area); }) {
         this->map = map_;
         this->map->setMapItem(this);
         this->metatileSelector = metatileSelector;
@@ -27,6 +26,7 @@ public:
         this->lockedAxis = MapPixmapItem::Axis::None;
         this->prevStraightPathState = false;
         setAcceptHoverEvents(true);
+        setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
     }
     MapPixmapItem::PaintMode paintingMode;
     Map *map;
@@ -75,12 +75,21 @@ public:
     virtual void shift(QGraphicsSceneMouseEvent*);
     void shift(int xDelta, int yDelta, bool fromScriptCall = false);
     virtual void draw(bool ignoreCache = false);
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
     void updateMetatileSelection(QGraphicsSceneMouseEvent *event);
     void paintNormal(int x, int y, bool fromScriptCall = false);
     void paintRandom(int x, int y, bool fromScriptCall = false);
     void lockNondominantAxis(QGraphicsSceneMouseEvent *event);
     QPoint adjustCoords(QPoint pos);
 
+protected:
+    // The map image is split into chunks that are only rendered while they're visible.
+    MapChunkCache chunks;
+    virtual void renderChunk(QImage *image, const QRect &area);
+    void updateChunks(const QRect &dirtyArea, bool ignoreCache);
+
 private:
     void paintSmartPath(int x, int y, bool fromScriptCall = false);
     static QList<int> smartPathTable;
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui qml
+QT       += core gui qml concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -23,12 +23,16 @@ SOURCES += src/core/block.cpp \
     src/core/map.cpp \
     src/core/maplayout.cpp \
     src/core/mapparser.cpp \
+    src/core/mapprefetcher.cpp \
     src/core/metatile.cpp \
+    src/core/metatileimagecache.cpp \
     src/core/metatileparser.cpp \
     src/core/paletteutil.cpp \
     src/core/parseutil.cpp \
+    src/core/projectcache.cpp \
     src/core/tile.cpp \
     src/core/tileset.cpp \
+    src/core/tilerenderer.cpp \
     src/core/regionmap.cpp \
     src/core/wildmoninfo.cpp \
     src/core/editcommands.cpp \
@@ -41,6 +45,7 @@ SOURCES += src/core/block.cpp \
     src/scriptapi/apioverlay.cpp \
     src/scriptapi/apiutility.cpp \
     src/scriptapi/scripting.cpp \
+    src/scriptapi/scriptworker.cpp \
     src/ui/aboutporymap.cpp \
     src/ui/customscriptseditor.cpp \
     src/ui/customscriptslistitem.cpp \
@@ -60,6 +65,7 @@ SOURCES += src/core/block.cpp \
     src/ui/filterchildrenproxymodel.cpp \
     src/ui/graphicsview.cpp \
     src/ui/imageproviders.cpp \
+    src/ui/mapchunkcache.cpp \
     src/ui/mappixmapitem.cpp \
     src/ui/prefabcreationdialog.cpp \
     src/ui/regionmappixmapitem.cpp \
@@ -96,6 +102,7 @@ SOURCES += src/core/block.cpp \
     src/ui/colorpicker.cpp \
     src/config.cpp \
     src/editor.cpp \
+    src/headlessrunner.cpp \
     src/main.cpp \
     src/mainwindow.cpp \
     src/project.cpp \
@@ -113,12 +120,16 @@ HEADERS  += include/core/block.h \
     include/core/mapconnection.h \
     include/core/maplayout.h \
     include/core/mapparser.h \
+    include/core/mapprefetcher.h \
     include/core/metatile.h \
+    include/core/metatileimagecache.h \
     include/core/metatileparser.h \
     include/core/paletteutil.h \
     include/core/parseutil.h \
+    include/core/projectcache.h \
     include/core/tile.h \
     include/core/tileset.h \
+    include/core/tilerenderer.h \
     include/core/regionmap.h \
     include/core/wildmoninfo.h \
     include/core/editcommands.h \
@@ -149,6 +160,7 @@ HEADERS  += include/core/block.h \
     include/ui/filterchildrenproxymodel.h \
     include/ui/graphicsview.h \
     include/ui/imageproviders.h \
+    include/ui/mapchunkcache.h \
     include/ui/mappixmapitem.h \
     include/ui/mapview.h \
     include/ui/prefabcreationdialog.h \
@@ -188,10 +200,12 @@ HEADERS  += include/core/block.h \
     include/ui/colorpicker.h \
     include/config.h \
     include/editor.h \
+    include/headlessrunner.h \
     include/mainwindow.h \
     include/project.h \
     include/scripting.h \
     include/scriptutility.h \
+    include/scriptworker.h \
     include/settings.h \
     include/log.h \
     include/ui/uintspinbox.h
@@ -267,6 +267,12 @@ void PorymapConfig::parseConfigKeyValue(QString key, QString value) {
         if (this->paletteEditorBitDepth != 15 && this->paletteEditorBitDepth != 24){
             this->paletteEditorBitDepth = 24;
         }
+    } else if (key == "prefetch_memory_budget") {
+        this->prefetchMemoryBudget = getConfigInteger(key, value, 0, 4096, 64);
+    } else if (key == "map_cache_memory_budget") {
+        this->mapCacheMemoryBudget = getConfigInteger(key, value, 16, 65536, 256);
+    } else if (key == "undo_history_memory_budget") {
+        this->undoHistoryMemoryBudget = getConfigInteger(key, value, 0, 4096, 16);
     } else {
         logWarn(QString("Invalid config key found in config file %1: '%2'").arg(this->getConfigFilepath()).arg(key));
     }
@@ -304,6 +310,9 @@ QMap<QString, QString> PorymapConfig::getKeyValueMap() {
     map.insert("text_editor_open_directory", this->textEditorOpenFolder);
     map.insert("text_editor_goto_line", this->textEditorGotoLine);
     map.insert("palette_editor_bit_depth", QString("%1").arg(this->paletteEditorBitDepth));
+    map.insert("prefetch_memory_budget", QString("%1").arg(this->prefetchMemoryBudget));
+    map.insert("map_cache_memory_budget", QString("%1").arg(this->mapCacheMemoryBudget));
+    map.insert("undo_history_memory_budget", QString("%1").arg(this->undoHistoryMemoryBudget));
     
     return map;
 }
@@ -443,6 +452,21 @@ void PorymapConfig::setPaletteEditorBitDepth(int bitDepth) {
     this->save();
 }
 
+void PorymapConfig::setPrefetchMemoryBudget(int megabytes) {
+    this->prefetchMemoryBudget = megabytes;
+    this->save();
+}
+
+void PorymapConfig::setMapCacheMemoryBudget(int megabytes) {
+    this->mapCacheMemoryBudget = megabytes;
+    this->save();
+}
+
+void PorymapConfig::setUndoHistoryMemoryBudget(int megabytes) {
+    this->undoHistoryMemoryBudget = megabytes;
+    this->save();
+}
+
 QString PorymapConfig::getRecentProject() {
     return this->recentProject;
 }
@@ -563,6 +587,18 @@ int PorymapConfig::getPaletteEditorBitDepth() {
     return this->paletteEditorBitDepth;
 }
 
+int PorymapConfig::getPrefetchMemoryBudget() {
+    return this->prefetchMemoryBudget;
+}
+
+int PorymapConfig::getMapCacheMemoryBudget() {
+    return this->mapCacheMemoryBudget;
+}
+
+int PorymapConfig::getUndoHistoryMemoryBudget() {
+    return this->undoHistoryMemoryBudget;
+}
+
 const QStringList ProjectConfig::versionStrings = {
     "pokeruby",
     "pokefirered",
@@ -759,6 +795,8 @@ void ProjectConfig::onNewConfigFileCreated() {
     if (baseGameVersionReverseMap.contains(dirName)) {
         this->baseGameVersion = baseGameVersionReverseMap.value(dirName);
         logInfo(QString("Auto-detected base_game_version as '%1'").arg(dirName));
+    } else if (!this->interactive) {
+        logWarn(QString("Could not detect base_game_version, using '%1'").arg(baseGameVersionMap.value(this->baseGameVersion)));
     } else {
         QDialog dialog(nullptr, Qt::WindowTitleHint);
         dialog.setWindowTitle("Project Configuration");
@@ -1,5 +1,28 @@
 #include "blockdata.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define BLOCKDATA_SSE2
+#include <emmintrin.h>
+#endif
+
+// Blocks are bitfields, so whether their memory has the same layout as rawValue() depends on the compiler.
+// It does for all of the compilers Porymap supports, but the packed words are only used directly if that's been checked.
+static bool blocksArePacked() {
+    static const bool packed = [] {
+        if (sizeof(Block) != sizeof(uint16_t))
+            return false;
+        const Block block(0x3A5, 0x2, 0xB);
+        uint16_t word;
+        memcpy(&word, &block, sizeof(word));
+        return word == block.rawValue();
+    }();
+    return packed;
+}
+
 QByteArray Blockdata::serialize() const {
     QByteArray data;
     for (const auto &block : *this) {
@@ -9,3 +32,127 @@ QByteArray Blockdata::serialize() const {
     }
     return data;
 }
+
+QVector<int> Blockdata::findMatching(uint16_t mask, uint16_t value) const {
+    QVector<int> matches;
+    value &= mask;
+    const int numBlocks = this->size();
+    if (!blocksArePacked()) {
+        for (int i = 0; i < numBlocks; i++) {
+            if ((this->at(i).rawValue() & mask) == value)
+                matches.append(i);
+        }
+        return matches;
+    }
+
+    const char *data = reinterpret_cast<const char *>(this->constData());
+    int i = 0;
+#ifdef BLOCKDATA_SSE2
+    // Compare 8 blocks at a time. Each matching block sets 2 bits of the byte mask.
+    const __m128i maskVector = _mm_set1_epi16(static_cast<short>(mask));
+    const __m128i valueVector = _mm_set1_epi16(static_cast<short>(value));
+    for (; i + 8 <= numBlocks; i += 8) {
+        const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * sizeof(Block)));
+        const int matched = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(words, maskVector), valueVector));
+        if (!matched)
+            continue;
+        for (int lane = 0; lane < 8; lane++) {
+            if (matched & (1 << (lane * 2)))
+                matches.append(i + lane);
+        }
+    }
+#endif
+    for (; i < numBlocks; i++) {
+        uint16_t word;
+        memcpy(&word, data + i * sizeof(Block), sizeof(word));
+        if ((word & mask) == value)
+            matches.append(i);
+    }
+    return matches;
+}
+
+BlockdataDelta::BlockdataDelta(const Blockdata &oldBlocks, const Blockdata &newBlocks) {
+    const int size = qMin(oldBlocks.size(), newBlocks.size());
+    for (int i = 0; i < size; i++) {
+        if (oldBlocks.at(i) != newBlocks.at(i))
+            appendChange(Change{i, oldBlocks.at(i), newBlocks.at(i)});
+    }
+}
+
+BlockdataDelta::BlockdataDelta(const QVector<BlockUpdate> &oldBlocks, const Blockdata &blockdata) {
+    QVector<BlockUpdate> sorted = oldBlocks;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const BlockUpdate &a, const BlockUpdate &b) {
+        return a.index < b.index;
+    });
+    int prevIndex = -1;
+    for (const BlockUpdate &old : sorted) {
+        if (old.index == prevIndex || old.index < 0 || old.index >= blockdata.size())
+            continue;
+        prevIndex = old.index;
+        if (old.block != blockdata.at(old.index))
+            appendChange(Change{old.index, old.block, blockdata.at(old.index)});
+    }
+}
+
+// Changes must be appended in order of increasing index.
+void BlockdataDelta::appendChange(const Change &change) {
+    if (this->runs.isEmpty() || this->runs.last().start + this->runs.last().newBlocks.size() != change.index) {
+        this->runs.append(Run{change.index, Blockdata(), Blockdata()});
+    }
+    Run &run = this->runs.last();
+    run.oldBlocks.append(change.oldBlock);
+    run.newBlocks.append(change.newBlock);
+}
+
+void BlockdataDelta::merge(const BlockdataDelta &other) {
+    // Both deltas' runs are sorted and don't overlap, so they can be merged in one pass over their changes.
+    QVector<Run> earlier = this->runs;
+    this->runs.clear();
+
+    int a = 0, aOffset = 0;
+    int b = 0, bOffset = 0;
+    while (a < earlier.size() || b < other.runs.size()) {
+        int aIndex = a < earlier.size() ? earlier.at(a).start + aOffset : INT_MAX;
+        int bIndex = b < other.runs.size() ? other.runs.at(b).start + bOffset : INT_MAX;
+
+        Change change;
+        change.index = qMin(aIndex, bIndex);
+        if (aIndex <= bIndex) {
+            change.oldBlock = earlier.at(a).oldBlocks.at(aOffset);
+            change.newBlock = earlier.at(a).newBlocks.at(aOffset);
+            if (++aOffset == earlier.at(a).oldBlocks.size()) {
+                a++;
+                aOffset = 0;
+            }
+        }
+        if (bIndex <= aIndex) {
+            if (bIndex != aIndex)
+                change.oldBlock = other.runs.at(b).oldBlocks.at(bOffset);
+            change.newBlock = other.runs.at(b).newBlocks.at(bOffset);
+            if (++bOffset == other.runs.at(b).oldBlocks.size()) {
+                b++;
+                bOffset = 0;
+            }
+        }
+        if (change.oldBlock != change.newBlock)
+            appendChange(change);
+    }
+}
+
+void BlockdataDelta::apply(Blockdata *blockdata, bool undo) const {
+    for (const Run &run : this->runs) {
+        const Blockdata &blocks = undo ? run.oldBlocks : run.newBlocks;
+        const int end = qMin(run.start + blocks.size(), blockdata->size());
+        for (int i = run.start; i < end; i++) {
+            (*blockdata)[i] = blocks.at(i - run.start);
+        }
+    }
+}
+
+qint64 BlockdataDelta::byteSize() const {
+    qint64 size = this->runs.size() * static_cast<qint64>(sizeof(Run));
+    for (const Run &run : this->runs) {
+        size += (run.oldBlocks.size() + run.newBlocks.size()) * static_cast<qint64>(sizeof(Block));
+    }
+    return size;
+}
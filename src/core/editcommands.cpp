@@ -25,19 +25,119 @@ int getEventTypeMask(QList<Event *> events) {
     return eventTypeMask;
 }
 
+static qint64 blockdataBytes(const Blockdata &blockdata) {
+    return blockdata.size() * static_cast<qint64>(sizeof(Block));
+}
+
+void MapBlocksCommand::release() {
+    if (this->released)
+        return;
+    this->releaseBlocks();
+    this->released = true;
+    setText(QString("%1 (compacted)").arg(text()));
+}
+
+void trimMapEditHistory(QUndoStack *history, qint64 maxBytes) {
+    if (maxBytes <= 0)
+        return;
+
+    // The commands are owned by the history, which only gives const access to them.
+    auto getBlocksCommand = [history](int i) {
+        return const_cast<MapBlocksCommand *>(dynamic_cast<const MapBlocksCommand *>(history->command(i)));
+    };
+
+    qint64 totalBytes = 0;
+    for (int i = 0; i < history->count(); i++) {
+        MapBlocksCommand *command = getBlocksCommand(i);
+        if (command)
+            totalBytes += command->byteSize();
+    }
+    if (totalBytes <= maxBytes)
+        return;
+
+    // Only commands that are currently applied can be changed, and the most recent one is left alone
+    // so that it can still merge with new commands.
+    const int end = history->index() - 1;
+
+    // Merge runs of deltas into a checkpoint at the start of each run. The intermediate steps of a run can't
+    // be undone to afterwards. Event commands don't change blocks, so they don't interrupt a run.
+    MapBlocksCommand *checkpoint = nullptr;
+    int checkpointIndex = -1;
+    for (int i = 0; i < end && totalBytes > maxBytes; i++) {
+        MapBlocksCommand *command = getBlocksCommand(i);
+        if (!command)
+            continue;
+        if (command->isReleased() || !command->getDelta()) {
+            checkpoint = nullptr;
+            continue;
+        }
+        if (!checkpoint) {
+            checkpoint = command;
+            checkpointIndex = i;
+            continue;
+        }
+
+        totalBytes -= checkpoint->byteSize() + command->byteSize();
+        checkpoint->getDelta()->merge(*command->getDelta());
+        command->release();
+        totalBytes += checkpoint->byteSize();
+
+        // The saved state might have been one of the steps that were merged away.
+        const int cleanIndex = history->cleanIndex();
+        if (cleanIndex > checkpointIndex && cleanIndex <= i)
+            history->resetClean();
+    }
+
+    // Then release the oldest commands. Undoing past the released commands no longer changes the blocks.
+    for (int i = 0; i < end && totalBytes > maxBytes; i++) {
+        MapBlocksCommand *command = getBlocksCommand(i);
+        if (!command || command->isReleased())
+            continue;
+        totalBytes -= command->byteSize();
+        command->release();
+        if (history->cleanIndex() >= 0 && history->cleanIndex() <= i)
+            history->resetClean();
+    }
+}
+
 void renderMapBlocks(Map *map, bool ignoreCache = false) {
-    map->mapItem->draw(ignoreCache);
-    map->collisionItem->draw(ignoreCache);
+    // Maps that aren't open (e.g. edited by a script worker) have nothing to render.
+    if (map->mapItem)
+        map->mapItem->draw(ignoreCache);
+    if (map->collisionItem)
+        map->collisionItem->draw(ignoreCache);
+}
+
+// Sets the blocks changed by the delta on the map, and keeps the layout's last committed blocks in sync.
+// Unlike replacing the whole blockdata, this only visits the changed blocks.
+static void applyBlockdataDelta(Map *map, const BlockdataDelta &delta, bool undo) {
+    map->applyBlockdataDelta(delta, undo, true);
+
+    Blockdata *lastCommitBlocks = &map->layout->lastCommitBlocks.blocks;
+    if (lastCommitBlocks->size() == map->layout->blockdata.size()) {
+        delta.apply(lastCommitBlocks, undo);
+    } else {
+        *lastCommitBlocks = map->layout->blockdata;
+    }
 }
 
 PaintMetatile::PaintMetatile(Map *map,
     const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
-    unsigned actionId, QUndoCommand *parent) : QUndoCommand(parent) {
+    unsigned actionId, QUndoCommand *parent) : MapBlocksCommand(parent) {
     setText("Paint Metatiles");
 
     this->map = map;
-    this->oldMetatiles = oldMetatiles;
-    this->newMetatiles = newMetatiles;
+    this->delta = BlockdataDelta(oldMetatiles, newMetatiles);
+
+    this->actionId = actionId;
+}
+
+PaintMetatile::PaintMetatile(Map *map, const BlockdataDelta &delta,
+    unsigned actionId, QUndoCommand *parent) : MapBlocksCommand(parent) {
+    setText("Paint Metatiles");
+
+    this->map = map;
+    this->delta = delta;
 
     this->actionId = actionId;
 }
@@ -45,21 +145,17 @@ PaintMetatile::PaintMetatile(Map *map,
 void PaintMetatile::redo() {
     QUndoCommand::redo();
 
-    if (!map) return;
-
-    map->setBlockdata(newMetatiles, true);
+    if (!map || released) return;
 
-    map->layout->lastCommitBlocks.blocks = map->layout->blockdata;
+    applyBlockdataDelta(map, delta, false);
 
     renderMapBlocks(map);
 }
 
 void PaintMetatile::undo() {
-    if (!map) return;
+    if (!map || released) return;
 
-    map->setBlockdata(oldMetatiles, true);
-
-    map->layout->lastCommitBlocks.blocks = map->layout->blockdata;
+    applyBlockdataDelta(map, delta, true);
 
     renderMapBlocks(map);
 
@@ -69,13 +165,13 @@ void PaintMetatile::undo() {
 bool PaintMetatile::mergeWith(const QUndoCommand *command) {
     const PaintMetatile *other = static_cast<const PaintMetatile *>(command);
 
-    if (map != other->map)
+    if (map != other->map || released)
         return false;
 
     if (actionId != other->actionId)
         return false;
 
-    newMetatiles = other->newMetatiles;
+    delta.merge(other->delta);
 
     return true;
 }
@@ -86,7 +182,7 @@ bool PaintMetatile::mergeWith(const QUndoCommand *command) {
 
 PaintBorder::PaintBorder(Map *map,
     const Blockdata &oldBorder, const Blockdata &newBorder,
-    unsigned actionId, QUndoCommand *parent) : QUndoCommand(parent) {
+    unsigned actionId, QUndoCommand *parent) : MapBlocksCommand(parent) {
     setText("Paint Border");
 
     this->map = map;
@@ -99,39 +195,49 @@ PaintBorder::PaintBorder(Map *map,
 void PaintBorder::redo() {
     QUndoCommand::redo();
 
-    if (!map) return;
+    if (!map || released) return;
 
     map->setBorderBlockData(newBorder, true);
 
     map->layout->lastCommitBlocks.border = map->layout->border;
 
-    map->borderItem->draw();
+    if (map->borderItem)
+        map->borderItem->draw();
 }
 
 void PaintBorder::undo() {
-    if (!map) return;
+    if (!map || released) return;
 
     map->setBorderBlockData(oldBorder, true);
 
     map->layout->lastCommitBlocks.border = map->layout->border;
 
-    map->borderItem->draw();
+    if (map->borderItem)
+        map->borderItem->draw();
 
     QUndoCommand::undo();
 }
 
+qint64 PaintBorder::byteSize() const {
+    return blockdataBytes(newBorder) + blockdataBytes(oldBorder);
+}
+
+void PaintBorder::releaseBlocks() {
+    newBorder.clear();
+    oldBorder.clear();
+}
+
 /******************************************************************************
     ************************************************************************
  ******************************************************************************/
 
 ShiftMetatiles::ShiftMetatiles(Map *map,
     const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
-    unsigned actionId, QUndoCommand *parent) : QUndoCommand(parent) {
+    unsigned actionId, QUndoCommand *parent) : MapBlocksCommand(parent) {
     setText("Shift Metatiles");
 
     this->map = map;
-    this->oldMetatiles = oldMetatiles;
-    this->newMetatiles = newMetatiles;
+    this->delta = BlockdataDelta(oldMetatiles, newMetatiles);
 
     this->actionId = actionId;
 }
@@ -139,21 +245,17 @@ ShiftMetatiles::ShiftMetatiles(Map *map,
 void ShiftMetatiles::redo() {
     QUndoCommand::redo();
 
-    if (!map) return;
-
-    map->setBlockdata(newMetatiles, true);
+    if (!map || released) return;
 
-    map->layout->lastCommitBlocks.blocks = map->layout->blockdata;
+    applyBlockdataDelta(map, delta, false);
 
     renderMapBlocks(map, true);
 }
 
 void ShiftMetatiles::undo() {
-    if (!map) return;
-
-    map->setBlockdata(oldMetatiles, true);
+    if (!map || released) return;
 
-    map->layout->lastCommitBlocks.blocks = map->layout->blockdata;
+    applyBlockdataDelta(map, delta, true);
 
     renderMapBlocks(map, true);
 
@@ -163,13 +265,13 @@ void ShiftMetatiles::undo() {
 bool ShiftMetatiles::mergeWith(const QUndoCommand *command) {
     const ShiftMetatiles *other = static_cast<const ShiftMetatiles *>(command);
 
-    if (this->map != other->map)
+    if (this->map != other->map || this->released)
         return false;
 
     if (actionId != other->actionId)
         return false;
 
-    this->newMetatiles = other->newMetatiles;
+    this->delta.merge(other->delta);
 
     return true;
 }
@@ -182,7 +284,7 @@ ResizeMap::ResizeMap(Map *map, QSize oldMapDimensions, QSize newMapDimensions,
     const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
     QSize oldBorderDimensions, QSize newBorderDimensions,
     const Blockdata &oldBorder, const Blockdata &newBorder,
-    QUndoCommand *parent) : QUndoCommand(parent) {
+    QUndoCommand *parent) : MapBlocksCommand(parent) {
     setText("Resize Map");
 
     this->map = map;
@@ -209,7 +311,7 @@ ResizeMap::ResizeMap(Map *map, QSize oldMapDimensions, QSize newMapDimensions,
 void ResizeMap::redo() {
     QUndoCommand::redo();
 
-    if (!map) return;
+    if (!map || released) return;
 
     map->layout->blockdata = newMetatiles;
     map->setDimensions(newMapWidth, newMapHeight, false, true);
@@ -224,7 +326,7 @@ void ResizeMap::redo() {
 }
 
 void ResizeMap::undo() {
-    if (!map) return;
+    if (!map || released) return;
 
     map->layout->blockdata = oldMetatiles;
     map->setDimensions(oldMapWidth, oldMapHeight, false, true);
@@ -240,6 +342,18 @@ void ResizeMap::undo() {
     QUndoCommand::undo();
 }
 
+qint64 ResizeMap::byteSize() const {
+    return blockdataBytes(newMetatiles) + blockdataBytes(oldMetatiles)
+         + blockdataBytes(newBorder) + blockdataBytes(oldBorder);
+}
+
+void ResizeMap::releaseBlocks() {
+    newMetatiles.clear();
+    oldMetatiles.clear();
+    newBorder.clear();
+    oldBorder.clear();
+}
+
 /******************************************************************************
     ************************************************************************
  ******************************************************************************/
@@ -492,7 +606,7 @@ ScriptEditMap::ScriptEditMap(Map *map,
         const Blockdata &oldMetatiles, const Blockdata &newMetatiles,
         QSize oldBorderDimensions, QSize newBorderDimensions,
         const Blockdata &oldBorder, const Blockdata &newBorder,
-        QUndoCommand *parent) : QUndoCommand(parent) {
+        QUndoCommand *parent) : MapBlocksCommand(parent) {
     setText("Script Edit Map");
 
     this->map = map;
@@ -517,7 +631,7 @@ ScriptEditMap::ScriptEditMap(Map *map,
 void ScriptEditMap::redo() {
     QUndoCommand::redo();
 
-    if (!map) return;
+    if (!map || released) return;
 
     if (newMapWidth != map->getWidth() || newMapHeight != map->getHeight()) {
         map->layout->blockdata = newMetatiles;
@@ -539,11 +653,12 @@ void ScriptEditMap::redo() {
     map->layout->lastCommitBlocks.borderDimensions = QSize(newBorderWidth, newBorderHeight);
 
     renderMapBlocks(map);
-    map->borderItem->draw();
+    if (map->borderItem)
+        map->borderItem->draw();
 }
 
 void ScriptEditMap::undo() {
-    if (!map) return;
+    if (!map || released) return;
 
     if (oldMapWidth != map->getWidth() || oldMapHeight != map->getHeight()) {
         map->layout->blockdata = oldMetatiles;
@@ -565,7 +680,20 @@ void ScriptEditMap::undo() {
     map->layout->lastCommitBlocks.borderDimensions = QSize(oldBorderWidth, oldBorderHeight);
 
     renderMapBlocks(map);
-    map->borderItem->draw();
+    if (map->borderItem)
+        map->borderItem->draw();
 
     QUndoCommand::undo();
 }
+
+qint64 ScriptEditMap::byteSize() const {
+    return blockdataBytes(newMetatiles) + blockdataBytes(oldMetatiles)
+         + blockdataBytes(newBorder) + blockdataBytes(oldBorder);
+}
+
+void ScriptEditMap::releaseBlocks() {
+    newMetatiles.clear();
+    oldMetatiles.clear();
+    newBorder.clear();
+    oldBorder.clear();
+}
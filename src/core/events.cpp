@@ -372,6 +372,7 @@ void CloneObjectEvent::loadPixmap(Project *project) {
     // Try to get the targeted object to clone
     int eventIndex = this->targetID - 1;
     Map *clonedMap = project->getMap(this->targetMap);
+    project->loadMapEvents(clonedMap);
     Event *clonedEvent = clonedMap ? clonedMap->events[Event::Group::Object].value(eventIndex, nullptr) : nullptr;
 
     if (clonedEvent && clonedEvent->getEventType() == Event::Type::Object) {
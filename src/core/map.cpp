@@ -2,6 +2,7 @@
 #include "map.h"
 #include "imageproviders.h"
 #include "scripting.h"
+#include "config.h"
 
 #include "editcommands.h"
 
@@ -9,11 +10,19 @@
 #include <QPainter>
 #include <QImage>
 #include <QRegularExpression>
+#include <QBitArray>
 
 
 Map::Map(QObject *parent) : QObject(parent)
 {
     editHistory.setClean();
+
+    // Keep the history within its memory budget whenever a command is added (or merged into the last one).
+    connect(&editHistory, &QUndoStack::indexChanged, this, [this](int index) {
+        if (index == editHistory.count()) {
+            trimMapEditHistory(&editHistory, static_cast<qint64>(porymapConfig.getUndoHistoryMemoryBudget()) * 1024 * 1024);
+        }
+    });
 }
 
 Map::~Map() {
@@ -60,15 +69,6 @@ int Map::getBorderHeight() {
     return layout->getBorderHeight();
 }
 
-bool Map::mapBlockChanged(int i, const Blockdata &cache) {
-    if (cache.length() <= i)
-        return true;
-    if (layout->blockdata.length() <= i)
-        return true;
-
-    return layout->blockdata.at(i) != cache.at(i);
-}
-
 bool Map::borderBlockChanged(int i, const Blockdata &cache) {
     if (cache.length() <= i)
         return true;
@@ -88,92 +88,131 @@ void Map::cacheBorder() {
         layout->cached_border.append(block);
 }
 
-void Map::cacheBlockdata() {
-    layout->cached_blockdata.clear();
-    for (const auto &block : layout->blockdata)
-        layout->cached_blockdata.append(block);
+void Map::markDirty(const QRect &area) {
+    dirtyMetatileArea |= area;
+    dirtyCollisionArea |= area;
+    dirtyMapItemArea |= area;
+    dirtyCollisionItemArea |= area;
+}
+
+QRect Map::takeDirtyMapItemArea() {
+    QRect area = dirtyMapItemArea;
+    dirtyMapItemArea = QRect();
+    return area;
+}
+
+QRect Map::takeDirtyCollisionItemArea() {
+    QRect area = dirtyCollisionItemArea;
+    dirtyCollisionItemArea = QRect();
+    return area;
+}
+
+// Draws the metatiles in the given area of the map, with the area's top-left metatile drawn at destOrigin.
+void Map::renderMetatiles(QImage *dest, const QRect &area, const QPoint &destOrigin, MapLayout *fromLayout) {
+    int width_ = getWidth();
+    for (int map_y = area.top(); map_y <= area.bottom(); map_y++)
+    for (int map_x = area.left(); map_x <= area.right(); map_x++) {
+        QPoint metatile_origin = destOrigin + QPoint(map_x - area.left(), map_y - area.top()) * 16;
+        Block block = layout->blockdata.value(map_y * width_ + map_x);
+        QImage metatile_image = getMetatileImage(
+            block.metatileId,
+            fromLayout ? fromLayout->tileset_primary   : layout->tileset_primary,
+            fromLayout ? fromLayout->tileset_secondary : layout->tileset_secondary,
+            metatileLayerOrder,
+            metatileLayerOpacity
+        );
+        drawMetatileImage(dest, metatile_origin, metatile_image);
+    }
+}
+
+void Map::renderCollisionMetatiles(QImage *dest, const QRect &area, const QPoint &destOrigin) {
+    int width_ = getWidth();
+    QPainter painter(dest);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int map_y = area.top(); map_y <= area.bottom(); map_y++)
+    for (int map_x = area.left(); map_x <= area.right(); map_x++) {
+        Block block = layout->blockdata.value(map_y * width_ + map_x);
+        QImage collision_metatile_image = getCollisionMetatileImage(block);
+        QPoint metatile_origin = destOrigin + QPoint(map_x - area.left(), map_y - area.top()) * 16;
+        painter.drawImage(metatile_origin, collision_metatile_image);
+    }
+    painter.end();
 }
 
-void Map::cacheCollision() {
-    layout->cached_collision.clear();
-    for (const auto &block : layout->blockdata)
-        layout->cached_collision.append(block);
+void Map::markAllDirty() {
+    markDirty(QRect(0, 0, getWidth(), getHeight()));
+}
+
+// Copy the given area (in metatiles) of an image into its pixmap.
+// Only the changed area is converted, rather than the whole image with QPixmap::fromImage.
+static void updatePixmapArea(QPixmap *pixmap, const QImage &image, const QRect &area) {
+    if (pixmap->isNull() || pixmap->size() != image.size()) {
+        *pixmap = QPixmap::fromImage(image);
+        return;
+    }
+    QRect pixelArea(area.x() * 16, area.y() * 16, area.width() * 16, area.height() * 16);
+    QPainter painter(pixmap);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(pixelArea.topLeft(), image, pixelArea);
+    painter.end();
 }
 
 QPixmap Map::renderCollision(bool ignoreCache) {
-    bool changed_any = false;
     int width_ = getWidth();
     int height_ = getHeight();
     if (collision_image.isNull() || collision_image.width() != width_ * 16 || collision_image.height() != height_ * 16) {
         collision_image = QImage(width_ * 16, height_ * 16, QImage::Format_RGBA8888);
-        changed_any = true;
+        ignoreCache = true;
     }
     if (layout->blockdata.isEmpty() || !width_ || !height_) {
         collision_pixmap = collision_pixmap.fromImage(collision_image);
         return collision_pixmap;
     }
-    QPainter painter(&collision_image);
-    for (int i = 0; i < layout->blockdata.length(); i++) {
-        if (!ignoreCache && !mapBlockChanged(i, layout->cached_collision)) {
-            continue;
-        }
-        changed_any = true;
-        Block block = layout->blockdata.at(i);
-        QImage collision_metatile_image = getCollisionMetatileImage(block);
-        int map_y = width_ ? i / width_ : 0;
-        int map_x = width_ ? i % width_ : 0;
-        QPoint metatile_origin = QPoint(map_x * 16, map_y * 16);
-        painter.drawImage(metatile_origin, collision_metatile_image);
-    }
-    painter.end();
-    cacheCollision();
-    if (changed_any) {
-        collision_pixmap = collision_pixmap.fromImage(collision_image);
+
+    // Only redraw the area that was changed since the last render.
+    const QRect mapArea(0, 0, width_, height_);
+    QRect area = ignoreCache ? mapArea : (dirtyCollisionArea & mapArea);
+    dirtyCollisionArea = QRect();
+    if (area.isEmpty()) {
+        return collision_pixmap;
     }
+
+    renderCollisionMetatiles(&collision_image, area, area.topLeft() * 16);
+    updatePixmapArea(&collision_pixmap, collision_image, area);
     return collision_pixmap;
 }
 
 QPixmap Map::render(bool ignoreCache, MapLayout * fromLayout, QRect bounds) {
-    bool changed_any = false;
     int width_ = getWidth();
     int height_ = getHeight();
     if (image.isNull() || image.width() != width_ * 16 || image.height() != height_ * 16) {
         image = QImage(width_ * 16, height_ * 16, QImage::Format_RGBA8888);
-        changed_any = true;
+        ignoreCache = true;
     }
     if (layout->blockdata.isEmpty() || !width_ || !height_) {
         pixmap = pixmap.fromImage(image);
         return pixmap;
     }
 
-    QPainter painter(&image);
-    for (int i = 0; i < layout->blockdata.length(); i++) {
-        if (!ignoreCache && !mapBlockChanged(i, layout->cached_blockdata)) {
-            continue;
-        }
-        changed_any = true;
-        int map_y = width_ ? i / width_ : 0;
-        int map_x = width_ ? i % width_ : 0;
-        if (bounds.isValid() && !bounds.contains(map_x, map_y)) {
-            continue;
-        }
-        QPoint metatile_origin = QPoint(map_x * 16, map_y * 16);
-        Block block = layout->blockdata.at(i);
-        QImage metatile_image = getMetatileImage(
-            block.metatileId,
-            fromLayout ? fromLayout->tileset_primary   : layout->tileset_primary,
-            fromLayout ? fromLayout->tileset_secondary : layout->tileset_secondary,
-            metatileLayerOrder,
-            metatileLayerOpacity
-        );
-        painter.drawImage(metatile_origin, metatile_image);
+    // Only redraw the area that was changed since the last render.
+    const QRect mapArea(0, 0, width_, height_);
+    QRect area = ignoreCache ? mapArea : (dirtyMetatileArea & mapArea);
+    if (bounds.isValid()) {
+        area &= bounds;
+    } else if (!fromLayout) {
+        dirtyMetatileArea = QRect();
     }
-    painter.end();
-    if (changed_any) {
-        cacheBlockdata();
-        pixmap = pixmap.fromImage(image);
+    if (fromLayout) {
+        // This area was drawn with another layout's tilesets, so it needs to be redrawn for this map.
+        dirtyMetatileArea |= area;
+    }
+    if (area.isEmpty()) {
+        return pixmap;
     }
 
+    renderMetatiles(&image, area, area.topLeft() * 16, fromLayout);
+    updatePixmapArea(&pixmap, image, area);
+
     return pixmap;
 }
 
@@ -193,7 +232,6 @@ QPixmap Map::renderBorder(bool ignoreCache) {
         layout->border_pixmap = layout->border_pixmap.fromImage(layout->border_image);
         return layout->border_pixmap;
     }
-    QPainter painter(&layout->border_image);
     for (int i = 0; i < layout->border.length(); i++) {
         if (!ignoreCache && (!border_resized && !borderBlockChanged(i, layout->cached_border))) {
             continue;
@@ -205,9 +243,8 @@ QPixmap Map::renderBorder(bool ignoreCache) {
         QImage metatile_image = getMetatileImage(metatileId, layout->tileset_primary, layout->tileset_secondary, metatileLayerOrder, metatileLayerOpacity);
         int map_y = width_ ? i / width_ : 0;
         int map_x = width_ ? i % width_ : 0;
-        painter.drawImage(QPoint(map_x * 16, map_y * 16), metatile_image);
+        drawMetatileImage(&layout->border_image, QPoint(map_x * 16, map_y * 16), metatile_image);
     }
-    painter.end();
     if (changed_any) {
         cacheBorder();
         layout->border_pixmap = layout->border_pixmap.fromImage(layout->border_image);
@@ -297,6 +334,7 @@ void Map::setDimensions(int newWidth, int newHeight, bool setNewBlockdata, bool
     int oldHeight = layout->height;
     layout->width = newWidth;
     layout->height = newHeight;
+    markAllDirty();
 
     if (enableScriptCallback && (oldWidth != newWidth || oldHeight != newHeight)) {
         Scripting::cb_MapResized(oldWidth, oldHeight, newWidth, newHeight);
@@ -342,6 +380,9 @@ void Map::setBlock(int x, int y, Block block, bool enableScriptCallback) {
     if (i < layout->blockdata.size()) {
         Block prevBlock = layout->blockdata.at(i);
         layout->blockdata.replace(i, block);
+        if (prevBlock != block) {
+            markDirty(QRect(x, y, 1, 1));
+        }
         if (enableScriptCallback) {
             Scripting::cb_MetatileChanged(x, y, prevBlock, block);
         }
@@ -349,17 +390,44 @@ void Map::setBlock(int x, int y, Block block, bool enableScriptCallback) {
 }
 
 void Map::setBlockdata(Blockdata blockdata, bool enableScriptCallback) {
+    ScriptBlockChangeBatch scriptBatch;
     int width = getWidth();
     int size = qMin(blockdata.size(), layout->blockdata.size());
+    QRect changedArea;
     for (int i = 0; i < size; i++) {
         Block prevBlock = layout->blockdata.at(i);
         Block newBlock = blockdata.at(i);
         if (prevBlock != newBlock) {
             layout->blockdata.replace(i, newBlock);
+            changedArea |= QRect(i % width, i / width, 1, 1);
             if (enableScriptCallback)
                 Scripting::cb_MetatileChanged(i % width, i / width, prevBlock, newBlock);
         }
     }
+    markDirty(changedArea);
+}
+
+// Sets only the blocks in the delta to their new (or, if 'undo' is true, old) values.
+void Map::applyBlockdataDelta(const BlockdataDelta &delta, bool undo, bool enableScriptCallback) {
+    ScriptBlockChangeBatch scriptBatch;
+    int width = getWidth();
+    int size = layout->blockdata.size();
+    QRect changedArea;
+    for (const BlockdataDelta::Run &run : delta.getRuns()) {
+        const Blockdata &blocks = undo ? run.oldBlocks : run.newBlocks;
+        for (int j = 0; j < blocks.size() && run.start + j < size; j++) {
+            int i = run.start + j;
+            Block prevBlock = layout->blockdata.at(i);
+            Block newBlock = blocks.at(j);
+            if (prevBlock != newBlock) {
+                layout->blockdata.replace(i, newBlock);
+                changedArea |= QRect(i % width, i / width, 1, 1);
+                if (enableScriptCallback)
+                    Scripting::cb_MetatileChanged(i % width, i / width, prevBlock, newBlock);
+            }
+        }
+    }
+    markDirty(changedArea);
 }
 
 uint16_t Map::getBorderMetatileId(int x, int y) {
@@ -392,64 +460,126 @@ void Map::setBorderBlockData(Blockdata blockdata, bool enableScriptCallback) {
     }
 }
 
-void Map::_floodFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation) {
-    QList<QPoint> todo;
-    todo.append(QPoint(x, y));
-    while (todo.length()) {
-        QPoint point = todo.takeAt(0);
-        x = point.x();
-        y = point.y();
-        Block block;
-        if (!getBlock(x, y, &block)) {
+// Sets each block in the list, writing to the blockdata directly.
+// Script callbacks are only invoked once all of the blocks have been set.
+// If 'delta' is given, it's set to the blocks that were changed, e.g. for an undo command.
+void Map::setBlocks(const QVector<BlockUpdate> &updates, bool enableScriptCallback, BlockdataDelta *delta) {
+    const int width = getWidth();
+    const int size = layout->blockdata.size();
+    Block *blocks = layout->blockdata.data();
+    QRect changedArea;
+    QVector<BlockUpdate> prevBlocks;
+    for (const BlockUpdate &update : updates) {
+        if (update.index < 0 || update.index >= size)
             continue;
-        }
-
-        uint old_coll = block.collision;
-        uint old_elev = block.elevation;
-        if (old_coll == collision && old_elev == elevation) {
+        Block prevBlock = blocks[update.index];
+        if (prevBlock == update.block)
+            continue;
+        blocks[update.index] = update.block;
+        changedArea |= QRect(update.index % width, update.index / width, 1, 1);
+        if (enableScriptCallback || delta)
+            prevBlocks.append(BlockUpdate{update.index, prevBlock});
+    }
+    markDirty(changedArea);
+    if (delta)
+        *delta = BlockdataDelta(prevBlocks, layout->blockdata);
+    if (!enableScriptCallback)
+        return;
+
+    ScriptBlockChangeBatch scriptBatch;
+    for (const BlockUpdate &prev : prevBlocks) {
+        Scripting::cb_MetatileChanged(prev.index % width, prev.index / width, prev.block, layout->blockdata.at(prev.index));
+    }
+}
+
+// Returns the indexes of the blocks connected to (x, y) whose raw values have the same bits set in 'mask'
+// as the block at (x, y), e.g. Block::metatileIdMask to find the area a bucket fill would cover.
+// This is a scanline fill: each row is filled in spans, and only the start of each matching span
+// in the rows above and below is queued.
+QVector<int> Map::getFloodFillArea(int x, int y, uint16_t mask) {
+    QVector<int> area;
+    const int width = getWidth();
+    const int height = getHeight();
+    if (!isWithinBounds(x, y) || layout->blockdata.size() < width * height)
+        return area;
+
+    const Block *blocks = layout->blockdata.constData();
+    const uint16_t target = blocks[y * width + x].rawValue() & mask;
+    QBitArray visited(width * height);
+    auto isOpen = [&](int i) {
+        return !visited.testBit(i) && (blocks[i].rawValue() & mask) == target;
+    };
+
+    QVector<QPoint> seeds;
+    seeds.append(QPoint(x, y));
+    while (!seeds.isEmpty()) {
+        const QPoint seed = seeds.takeLast();
+        const int row = seed.y() * width;
+        if (visited.testBit(row + seed.x()))
             continue;
-        }
 
-        block.collision = collision;
-        block.elevation = elevation;
-        setBlock(x, y, block, true);
-        if (getBlock(x + 1, y, &block) && block.collision == old_coll && block.elevation == old_elev) {
-            todo.append(QPoint(x + 1, y));
-        }
-        if (getBlock(x - 1, y, &block) && block.collision == old_coll && block.elevation == old_elev) {
-            todo.append(QPoint(x - 1, y));
+        int left = seed.x();
+        int right = seed.x();
+        while (left > 0 && isOpen(row + left - 1))
+            left--;
+        while (right < width - 1 && isOpen(row + right + 1))
+            right++;
+        for (int i = left; i <= right; i++) {
+            visited.setBit(row + i);
+            area.append(row + i);
         }
-        if (getBlock(x, y + 1, &block) && block.collision == old_coll && block.elevation == old_elev) {
-            todo.append(QPoint(x, y + 1));
-        }
-        if (getBlock(x, y - 1, &block) && block.collision == old_coll && block.elevation == old_elev) {
-            todo.append(QPoint(x, y - 1));
+
+        for (int adjacentY : {seed.y() - 1, seed.y() + 1}) {
+            if (adjacentY < 0 || adjacentY >= height)
+                continue;
+            const int adjacentRow = adjacentY * width;
+            bool inSpan = false;
+            for (int i = left; i <= right; i++) {
+                const bool open = isOpen(adjacentRow + i);
+                if (open && !inSpan)
+                    seeds.append(QPoint(i, adjacentY));
+                inSpan = open;
+            }
         }
     }
+    return area;
 }
 
 void Map::floodFillCollisionElevation(int x, int y, uint16_t collision, uint16_t elevation) {
     Block block;
-    if (getBlock(x, y, &block) && (block.collision != collision || block.elevation != elevation)) {
-        _floodFillCollisionElevation(x, y, collision, elevation);
+    if (!getBlock(x, y, &block) || (block.collision == collision && block.elevation == elevation))
+        return;
+
+    const QVector<int> area = getFloodFillArea(x, y, Block::collisionMask | Block::elevationMask);
+    const Block *blocks = layout->blockdata.constData();
+    QVector<BlockUpdate> updates;
+    updates.reserve(area.size());
+    for (int i : area) {
+        Block newBlock = blocks[i];
+        newBlock.collision = collision;
+        newBlock.elevation = elevation;
+        updates.append(BlockUpdate{i, newBlock});
     }
+    setBlocks(updates, true);
 }
 
-void Map::magicFillCollisionElevation(int initialX, int initialY, uint16_t collision, uint16_t elevation) {
+void Map::magicFillCollisionElevation(int initialX, int initialY, uint16_t collision, uint16_t elevation, BlockdataDelta *delta) {
     Block block;
     if (getBlock(initialX, initialY, &block) && (block.collision != collision || block.elevation != elevation)) {
-        uint old_coll = block.collision;
-        uint old_elev = block.elevation;
-
-        for (int y = 0; y < getHeight(); y++) {
-            for (int x = 0; x < getWidth(); x++) {
-                if (getBlock(x, y, &block) && block.collision == old_coll && block.elevation == old_elev) {
-                    block.collision = collision;
-                    block.elevation = elevation;
-                    setBlock(x, y, block, true);
-                }
-            }
+        const uint16_t mask = Block::collisionMask | Block::elevationMask;
+        const int numBlocks = getWidth() * getHeight();
+        const QVector<int> matches = layout->blockdata.findMatching(mask, block.rawValue());
+        QVector<BlockUpdate> updates;
+        updates.reserve(matches.size());
+        for (int i : matches) {
+            if (i >= numBlocks)
+                break;
+            Block newBlock = layout->blockdata.at(i);
+            newBlock.collision = collision;
+            newBlock.elevation = elevation;
+            updates.append(BlockUpdate{i, newBlock});
         }
+        setBlocks(updates, true, delta);
     }
 }
 
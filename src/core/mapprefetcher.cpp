@@ -0,0 +1,146 @@
+#include "mapprefetcher.h"
+#include "config.h"
+#include "imageproviders.h"
+#include "project.h"
+
+#include <QSet>
+
+// How long to wait before checking again whether a map's files and tilesets have finished loading
+static const int loadPollInterval = 50;
+// How long to wait between building prefetched maps, which happens on the main thread, so user input is handled in between
+static const int idleInterval = 20;
+
+MapPrefetcher::MapPrefetcher(Project *project) : QObject(project) {
+    this->project = project;
+    this->timer.setSingleShot(true);
+    connect(&this->timer, &QTimer::timeout, this, &MapPrefetcher::prefetchNext);
+}
+
+void MapPrefetcher::cancel() {
+    this->timer.stop();
+    this->queue.clear();
+    this->usedBytes = 0;
+}
+
+// Only queues the maps, nothing is read until each map reaches the front of the queue (see prefetchNext).
+void MapPrefetcher::prefetchNeighbors(Map *map) {
+    this->cancel();
+    this->budgetBytes = static_cast<qint64>(porymapConfig.getPrefetchMemoryBudget()) * 1024 * 1024;
+    if (!map || this->budgetBytes <= 0)
+        return;
+
+    QStringList mapNames;
+    for (const MapConnection *connection : map->connections) {
+        mapNames.append(connection->map_name);
+    }
+    for (Event *event : map->events.value(Event::Group::Warp)) {
+        WarpEvent *warp = dynamic_cast<WarpEvent *>(event);
+        if (warp)
+            mapNames.append(warp->getDestinationMap());
+    }
+
+    QSet<QString> queuedNames;
+    for (const QString &mapName : mapNames) {
+        if (mapName == map->name
+         || queuedNames.contains(mapName)
+         || this->project->mapCache.contains(mapName)
+         || !this->project->mapNames.contains(mapName))
+            continue;
+        this->queue.append(PendingMap{mapName});
+        queuedNames.insert(mapName);
+    }
+
+    this->scheduleNext();
+}
+
+void MapPrefetcher::scheduleNext() {
+    if (!this->queue.isEmpty())
+        this->timer.start(idleInterval);
+}
+
+void MapPrefetcher::prefetchNext() {
+    if (this->queue.isEmpty())
+        return;
+
+    PendingMap &next = this->queue.first();
+    if (this->project->mapCache.contains(next.name)) {
+        this->queue.removeFirst();
+        this->scheduleNext();
+        return;
+    }
+
+    // Read the map's map.json in the background to find its layout.
+    if (!next.layout) {
+        if (!next.readStarted) {
+            next.readStarted = true;
+            this->project->prefetchMapJson(next.name);
+        }
+        if (this->project->isMapJsonLoading(next.name)) {
+            this->timer.start(loadPollInterval);
+            return;
+        }
+        next.layout = this->project->getPrefetchedMapLayout(next.name);
+        if (!next.layout) {
+            // The map couldn't be read, it'll report its errors if it's opened.
+            this->queue.removeFirst();
+            this->scheduleNext();
+            return;
+        }
+
+        // Then read its blocks and decode its tilesets in the background.
+        this->project->prefetchLayoutBlockdata(next.layout);
+        for (const QString &label : {next.layout->tileset_primary_label, next.layout->tileset_secondary_label}) {
+            if (!this->project->tilesetCache.contains(label) && !this->project->isTilesetLoading(label))
+                next.newTilesetLabels.append(label);
+            this->project->prefetchTileset(label);
+        }
+    }
+
+    // Loading the map would block until its files and tilesets are ready, so wait for them instead.
+    if (this->project->isLayoutBlockdataLoading(next.layout)
+     || this->project->isTilesetLoading(next.layout->tileset_primary_label)
+     || this->project->isTilesetLoading(next.layout->tileset_secondary_label)) {
+        this->timer.start(loadPollInterval);
+        return;
+    }
+
+    // Everything has been read, so only the Map itself is built here on the main thread.
+    const PendingMap loaded = this->queue.takeFirst();
+    Map *map = this->project->getMap(loaded.name);
+    if (map)
+        this->usedBytes += renderMetatileImages(map);
+    for (const QString &label : loaded.newTilesetLabels) {
+        const Tileset *tileset = this->project->tilesetCache.value(label);
+        if (tileset)
+            this->usedBytes += Project::getTilesetBytes(tileset);
+    }
+
+    if (this->usedBytes >= this->budgetBytes) {
+        this->cancel();
+    } else {
+        this->scheduleNext();
+    }
+}
+
+// Renders the images of the metatiles used by the map into its tileset's cache, so the map can be displayed quickly.
+// Returns roughly how much memory the map's blockdata and rendered metatiles use.
+qint64 MapPrefetcher::renderMetatileImages(Map *map) {
+    if (!map->layout)
+        return 0;
+
+    QSet<uint16_t> metatileIds;
+    for (const Block &block : map->layout->blockdata) {
+        metatileIds.insert(block.metatileId);
+    }
+    for (const Block &block : map->layout->border) {
+        metatileIds.insert(block.metatileId);
+    }
+    for (uint16_t metatileId : metatileIds) {
+        getMetatileImage(metatileId, map->layout->tileset_primary, map->layout->tileset_secondary,
+                         map->metatileLayerOrder, map->metatileLayerOpacity);
+    }
+
+    const qint64 metatileImageBytes = 16 * 16 * 4;
+    return metatileIds.size() * metatileImageBytes
+         + (map->layout->blockdata.size() + map->layout->border.size()) * static_cast<qint64>(sizeof(Block));
+}
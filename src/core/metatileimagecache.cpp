@@ -0,0 +1,69 @@
+#include "metatileimagecache.h"
+#include "tileset.h"
+#include "config.h"
+
+// QByteArray's comparison doesn't check for shared data first, and the tile data is compared on every lookup.
+static bool tilePixelsEqual(const QByteArray &a, const QByteArray &b) {
+    return (a.constData() == b.constData() && a.size() == b.size()) || a == b;
+}
+
+void MetatileImageCache::validate(const Tileset *primaryTileset, const Tileset *secondaryTileset,
+                                  const QList<int> &layerOrder, const QList<float> &layerOpacity)
+{
+    bool tripleLayerMetatiles = projectConfig.getTripleLayerMetatilesEnabled();
+    if (this->primaryTileset == primaryTileset
+     && this->tripleLayerMetatiles == tripleLayerMetatiles
+     && this->layerOrder == layerOrder
+     && this->layerOpacity == layerOpacity
+     && tilePixelsEqual(this->primaryTilePixels, primaryTileset->tilePixels)
+     && tilePixelsEqual(this->secondaryTilePixels, secondaryTileset->tilePixels)
+     && this->primaryPalettes == primaryTileset->palettes
+     && this->secondaryPalettes == secondaryTileset->palettes
+     && this->primaryPalettePreviews == primaryTileset->palettePreviews
+     && this->secondaryPalettePreviews == secondaryTileset->palettePreviews) {
+        return;
+    }
+
+    this->entries.clear();
+    this->primaryTileset = primaryTileset;
+    this->tripleLayerMetatiles = tripleLayerMetatiles;
+    this->layerOrder = layerOrder;
+    this->layerOpacity = layerOpacity;
+    this->primaryTilePixels = primaryTileset->tilePixels;
+    this->secondaryTilePixels = secondaryTileset->tilePixels;
+    this->primaryPalettes = primaryTileset->palettes;
+    this->secondaryPalettes = secondaryTileset->palettes;
+    this->primaryPalettePreviews = primaryTileset->palettePreviews;
+    this->secondaryPalettePreviews = secondaryTileset->palettePreviews;
+}
+
+QImage MetatileImageCache::find(uint16_t metatileId, const Metatile *metatile, bool useTruePalettes) const {
+    auto it = this->entries.constFind(getKey(metatileId, useTruePalettes));
+    if (it == this->entries.constEnd() || !metatile)
+        return QImage();
+
+    // Metatiles are edited in-place, so make sure this one hasn't changed since its image was built.
+    if (it->layerType != metatile->layerType || it->tiles != metatile->tiles)
+        return QImage();
+
+    return it->image;
+}
+
+void MetatileImageCache::insert(uint16_t metatileId, const Metatile *metatile, bool useTruePalettes, const QImage &image) {
+    if (!metatile)
+        return;
+    this->entries.insert(getKey(metatileId, useTruePalettes), Entry{metatile->tiles, metatile->layerType, image});
+}
+
+void MetatileImageCache::clear() {
+    this->entries.clear();
+    this->primaryTileset = nullptr;
+    this->primaryTilePixels.clear();
+    this->secondaryTilePixels.clear();
+    this->primaryPalettes.clear();
+    this->secondaryPalettes.clear();
+    this->primaryPalettePreviews.clear();
+    this->secondaryPalettePreviews.clear();
+    this->layerOrder.clear();
+    this->layerOpacity.clear();
+}
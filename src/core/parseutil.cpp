@@ -3,8 +3,12 @@
 
 #include <QRegularExpression>
 #include <QJsonDocument>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
 #include <QJsonObject>
-#include <QStack>
+#include <algorithm>
 
 #include "lib/fex/lexer.h"
 #include "lib/fex/parser.h"
@@ -23,6 +27,34 @@ void ParseUtil::set_root(const QString &dir) {
     this->root = dir;
 }
 
+void ParseUtil::setCache(ProjectCache *cache) {
+    this->cache = cache;
+}
+
+// Parsed results are cached per source file, keyed by the parsing function and its arguments.
+template <typename T>
+bool ParseUtil::findCachedResult(const QString &filepath, const QString &key, T *out) {
+    QByteArray data;
+    if (!this->cache || !this->cache->find(filepath, key, &data))
+        return false;
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_14);
+    in >> *out;
+    return in.status() == QDataStream::Ok;
+}
+
+// Results that logged errors while parsing aren't cached, so the errors are reported again next time.
+template <typename T>
+void ParseUtil::cacheResult(const QString &filepath, const QString &key, const T &result) {
+    if (!this->cache || this->loggedParseErrors)
+        return;
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_14);
+    out << result;
+    this->cache->insert(filepath, key, data);
+}
+
 void ParseUtil::recordError(const QString &message) {
     this->errorMap[this->curDefine].append(message);
 }
@@ -35,6 +67,7 @@ void ParseUtil::recordErrors(const QStringList &errors) {
 void ParseUtil::logRecordedErrors() {
     QStringList errors = this->errorMap.value(this->curDefine);
     if (errors.isEmpty()) return;
+    this->loggedParseErrors = true;
     QString message = QString("Failed to parse '%1':").arg(this->curDefine);
     for (const auto error : errors)
         message.append(QString("\n%1").arg(error));
@@ -53,24 +86,71 @@ QString ParseUtil::createErrorMessage(const QString &message, const QString &exp
     return QString("%1:%2:%3: %4").arg(this->file).arg(lineNum).arg(colNum).arg(message);
 }
 
+// The contents of the text files read so far, so that files read by several functions
+// (or by the same function for different labels) are only read from disk once.
+struct CachedTextFile {
+    qint64 size;
+    QDateTime lastModified;
+    QString text;
+};
+static QHash<QString, CachedTextFile> textFileCache;
+static QMutex textFileCacheMutex;
+
 QString ParseUtil::readTextFile(const QString &path) {
+    const QFileInfo info(path);
+    {
+        QMutexLocker locker(&textFileCacheMutex);
+        auto it = textFileCache.constFind(path);
+        if (it != textFileCache.constEnd() && it->size == info.size() && it->lastModified == info.lastModified())
+            return it->text;
+    }
+
     QFile file(path);
     if (!file.open(QIODevice::ReadOnly)) {
         logError(QString("Could not open '%1': ").arg(path) + file.errorString());
         return QString();
     }
-    QTextStream in(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    in.setCodec("UTF-8");
-#endif // Qt6 defaults to UTF-8, but setCodec is renamed to setEncoding
-    QString text = "";
-    while (!in.atEnd()) {
-        text += in.readLine() + '\n';
-    }
 
+    // Decode the file straight from its mapped memory. Files that can't be mapped (e.g. compressed resources) are read instead.
+    QByteArray buffer;
+    qint64 length = file.size();
+    uchar *mapped = length > 0 ? file.map(0, length) : nullptr;
+    const char *data = reinterpret_cast<const char *>(mapped);
+    if (!mapped) {
+        buffer = file.readAll();
+        data = buffer.constData();
+        length = buffer.length();
+    }
+    // Skip the UTF-8 byte order mark
+    if (length >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+        data += 3;
+        length -= 3;
+    }
+    QString text = length > 0 ? QString::fromUtf8(data, static_cast<int>(length)) : QString("");
+    if (mapped)
+        file.unmap(mapped);
+
+    // Like QTextStream::readLine, normalize line endings and end the last line with a newline.
+    if (text.contains('\r'))
+        text.replace("\r\n", "\n");
+    if (!text.isEmpty() && !text.endsWith('\n'))
+        text.append('\n');
+
+    QMutexLocker locker(&textFileCacheMutex);
+    textFileCache.insert(path, CachedTextFile{info.size(), info.lastModified(), text});
     return text;
 }
 
+void ParseUtil::invalidateTextFile(const QString &path) {
+    QMutexLocker locker(&textFileCacheMutex);
+    textFileCache.remove(path);
+}
+
+void ParseUtil::clearTextFileCache() {
+    QMutexLocker locker(&textFileCacheMutex);
+    textFileCache.clear();
+}
+
 int ParseUtil::textFileLineCount(const QString &path) {
     const QString text = readTextFile(path);
     return text.split('\n').count() + 1;
@@ -106,183 +186,251 @@ QList<QStringList> ParseUtil::parseAsm(const QString &filename) {
     return parsed;
 }
 
-int ParseUtil::evaluateDefine(const QString &define, const QMap<QString, int> &knownDefines) {
-    QList<Token> tokens = tokenizeExpression(define, knownDefines);
-    QList<Token> postfixExpression = generatePostfix(tokens);
-    return evaluatePostfix(postfixExpression);
+// Define expressions are compiled into a list of postfix instructions.
+// Each instruction is an opcode, followed by an operand for the opcodes that push a value.
+enum ExpressionOp : int {
+    PushNumber,
+    PushDefine,
+    Negate,
+    Complement,
+    Multiply,
+    Divide,
+    Modulo,
+    Add,
+    Subtract,
+    LeftShift,
+    RightShift,
+    BitAnd,
+    BitXor,
+    BitOr,
+    LeftParen, // Only used while compiling
+};
+
+struct ExpressionOperator {
+    int op;
+    int precedence;
+};
+
+static const int unaryPrecedence = 2;
+static const QHash<QString, ExpressionOperator> binaryOperators = {
+    {"*",  {ExpressionOp::Multiply,   3}},
+    {"/",  {ExpressionOp::Divide,     3}},
+    {"%",  {ExpressionOp::Modulo,     3}},
+    {"+",  {ExpressionOp::Add,        4}},
+    {"-",  {ExpressionOp::Subtract,   4}},
+    {"<<", {ExpressionOp::LeftShift,  5}},
+    {">>", {ExpressionOp::RightShift, 5}},
+    {"&",  {ExpressionOp::BitAnd,     8}},
+    {"^",  {ExpressionOp::BitXor,     9}},
+    {"|",  {ExpressionOp::BitOr,      10}},
+};
+
+static bool isDecimalDigit(QChar c) {
+    return c.unicode() >= '0' && c.unicode() <= '9';
 }
 
-QList<Token> ParseUtil::tokenizeExpression(QString expression, const QMap<QString, int> &knownIdentifiers) {
-    QList<Token> tokens;
-
-    QStringList tokenTypes = (QStringList() << "hex" << "decimal" << "identifier" << "operator" << "leftparen" << "rightparen");
-    static const QRegularExpression re("^(?<hex>0x[0-9a-fA-F]+)|(?<decimal>[0-9]+)|(?<identifier>[a-zA-Z_0-9]+)|(?<operator>[+\\-*\\/<>|^%]+)|(?<leftparen>\\()|(?<rightparen>\\))");
+static bool isHexDigit(QChar c) {
+    const ushort u = c.unicode();
+    return isDecimalDigit(c) || (u >= 'a' && u <= 'f') || (u >= 'A' && u <= 'F');
+}
 
-    expression = expression.trimmed();
-    while (!expression.isEmpty()) {
-        QRegularExpressionMatch match = re.match(expression);
-        if (!match.hasMatch()) {
-            logWarn(QString("Failed to tokenize expression: '%1'").arg(expression));
-            break;
-        }
-        for (QString tokenType : tokenTypes) {
-            QString token = match.captured(tokenType);
-            if (!token.isEmpty()) {
-                if (tokenType == "identifier") {
-                    if (knownIdentifiers.contains(token)) {
-                        // Any errors encountered when this identifier was evaluated should be recorded for this expression as well.
-                        recordErrors(this->errorMap.value(token));
-                        QString actualToken = QString("%1").arg(knownIdentifiers.value(token));
-                        expression = expression.replace(0, token.length(), actualToken);
-                        token = actualToken;
-                        tokenType = "decimal";
-                    } else {
-                        tokenType = "error";
-                        QString message = QString("unknown token '%1' found in expression '%2'")
-                                          .arg(token).arg(expression);
-                        recordError(createErrorMessage(message, expression));
-                    }
-                }
-                else if (tokenType == "operator") {
-                    if (!Token::precedenceMap.contains(token)) {
-                        QString message = QString("unsupported postfix operator: '%1'")
-                                          .arg(token);
-                        recordError(createErrorMessage(message, expression));
-                    }
-                }
+static bool isIdentifierChar(QChar c) {
+    const ushort u = c.unicode();
+    return isDecimalDigit(c) || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || u == '_';
+}
 
-                tokens.append(Token(token, tokenType));
-                expression = expression.remove(0, token.length()).trimmed();
-                break;
-            }
-        }
+void ParseUtil::DefineTable::insert(const QString &name, int value) {
+    auto it = this->ids.constFind(name);
+    if (it != this->ids.constEnd()) {
+        this->values[it.value()] = value;
+    } else {
+        this->ids.insert(name, this->values.length());
+        this->values.append(value);
     }
-    return tokens;
 }
 
-QMap<QString, int> Token::precedenceMap = QMap<QString, int>(
-{
-    {"*", 3},
-    {"/", 3},
-    {"%", 3},
-    {"+", 4},
-    {"-", 4},
-    {"<<", 5},
-    {">>", 5},
-    {"&", 8},
-    {"^", 9},
-    {"|", 10}
-});
-
-// Shunting-yard algorithm for generating postfix notation.
+int ParseUtil::evaluateDefine(const QString &define, const QMap<QString, int> &knownDefines) {
+    DefineTable table;
+    table.knownDefines = &knownDefines;
+    return evaluateExpression(compileExpression(define, table), table);
+}
+
+// Converts the expression to postfix instructions, using the shunting-yard algorithm.
 // https://en.wikipedia.org/wiki/Shunting-yard_algorithm
-QList<Token> ParseUtil::generatePostfix(const QList<Token> &tokens) {
-    QList<Token> output;
-    QStack<Token> operatorStack;
-    for (Token token : tokens) {
-        if (token.type == TokenClass::Number) {
-            output.append(token);
-        } else if (token.value == "(") {
-            operatorStack.push(token);
-        } else if (token.value == ")") {
-            while (!operatorStack.empty() && operatorStack.top().value != "(") {
-                output.append(operatorStack.pop());
+// Identifiers are resolved to their index in the table, or to their value if they're one of its known defines.
+QVector<int> ParseUtil::compileExpression(const QString &expression, const DefineTable &table) {
+    static const QString operatorChars = "+-*/%<>&^|~";
+    QVector<int> code;
+    QVector<ExpressionOperator> operatorStack;
+    // True where the next token should be an operand, i.e. where '-', '+' and '~' are unary operators.
+    bool expectOperand = true;
+
+    const int length = expression.length();
+    int pos = 0;
+    while (pos < length) {
+        const QChar c = expression.at(pos);
+        if (c.isSpace()) {
+            pos++;
+            continue;
+        }
+
+        const int start = pos;
+        if (isDecimalDigit(c)) {
+            if (c == '0' && pos + 2 < length && expression.at(pos + 1).toLower() == 'x' && isHexDigit(expression.at(pos + 2))) {
+                pos += 2;
+                while (pos < length && isHexDigit(expression.at(pos))) pos++;
+            } else {
+                while (pos < length && isDecimalDigit(expression.at(pos))) pos++;
+            }
+            code << ExpressionOp::PushNumber << expression.mid(start, pos - start).toInt(nullptr, 0);
+            expectOperand = false;
+        } else if (isIdentifierChar(c)) {
+            while (pos < length && isIdentifierChar(expression.at(pos))) pos++;
+            const QString identifier = expression.mid(start, pos - start);
+            auto id = table.ids.constFind(identifier);
+            if (id != table.ids.constEnd()) {
+                // Any errors encountered when this identifier was evaluated should be recorded for this expression as well.
+                recordErrors(this->errorMap.value(identifier));
+                code << ExpressionOp::PushDefine << id.value();
+            } else if (table.knownDefines && table.knownDefines->contains(identifier)) {
+                recordErrors(this->errorMap.value(identifier));
+                code << ExpressionOp::PushNumber << table.knownDefines->value(identifier);
+            } else {
+                const QString remaining = expression.mid(start);
+                QString message = QString("unknown token '%1' found in expression '%2'")
+                                  .arg(identifier).arg(remaining);
+                recordError(createErrorMessage(message, remaining));
+                code << ExpressionOp::PushNumber << 0;
+            }
+            expectOperand = false;
+        } else if (c == '(') {
+            operatorStack.append(ExpressionOperator{ExpressionOp::LeftParen, 0});
+            pos++;
+            expectOperand = true;
+        } else if (c == ')') {
+            while (!operatorStack.isEmpty() && operatorStack.last().op != ExpressionOp::LeftParen) {
+                code << operatorStack.takeLast().op;
             }
-            if (!operatorStack.empty()) {
-                // pop the left parenthesis token
-                operatorStack.pop();
+            if (!operatorStack.isEmpty()) {
+                // pop the left parenthesis
+                operatorStack.removeLast();
             } else {
                 recordError("Mismatched parentheses detected in expression!");
             }
-        } else {
-            // token is an operator
+            pos++;
+            expectOperand = false;
+        } else if (operatorChars.contains(c)) {
+            const bool isShift = (c == '<' || c == '>') && pos + 1 < length && expression.at(pos + 1) == c;
+            pos += isShift ? 2 : 1;
+            const QString token = expression.mid(start, pos - start);
+            if (expectOperand && (c == '-' || c == '+' || c == '~')) {
+                // Unary operators are right-associative, so nothing is popped for them
+                if (c != '+')
+                    operatorStack.append(ExpressionOperator{c == '-' ? ExpressionOp::Negate : ExpressionOp::Complement, unaryPrecedence});
+                continue;
+            }
+            auto binaryOperator = binaryOperators.constFind(token);
+            if (binaryOperator == binaryOperators.constEnd()) {
+                QString message = QString("unsupported postfix operator: '%1'")
+                                  .arg(token);
+                recordError(createErrorMessage(message, expression.mid(start)));
+                expectOperand = true;
+                continue;
+            }
             while (!operatorStack.isEmpty()
-                   && operatorStack.top().operatorPrecedence <= token.operatorPrecedence
-                   && operatorStack.top().value != "(") {
-                output.append(operatorStack.pop());
+                   && operatorStack.last().op != ExpressionOp::LeftParen
+                   && operatorStack.last().precedence <= binaryOperator->precedence) {
+                code << operatorStack.takeLast().op;
             }
-            operatorStack.push(token);
+            operatorStack.append(*binaryOperator);
+            expectOperand = true;
+        } else {
+            logWarn(QString("Failed to tokenize expression: '%1'").arg(expression.mid(start)));
+            this->loggedParseErrors = true;
+            break;
         }
     }
 
     while (!operatorStack.isEmpty()) {
-        if (operatorStack.top().value == "(" || operatorStack.top().value == ")") {
+        if (operatorStack.last().op == ExpressionOp::LeftParen) {
             recordError("Mismatched parentheses detected in expression!");
+            operatorStack.removeLast();
         } else {
-            output.append(operatorStack.pop());
+            code << operatorStack.takeLast().op;
         }
     }
-
-    return output;
+    return code;
 }
 
-// Evaluate postfix expression.
+// Evaluate the postfix instructions of a compiled expression.
 // https://en.wikipedia.org/wiki/Reverse_Polish_notation#Postfix_evaluation_algorithm
-int ParseUtil::evaluatePostfix(const QList<Token> &postfix) {
-    QStack<Token> stack;
-    for (Token token : postfix) {
-        if (token.type == TokenClass::Operator && stack.size() > 1) {
-            int op2 = stack.pop().value.toInt(nullptr, 0);
-            int op1 = stack.pop().value.toInt(nullptr, 0);
+int ParseUtil::evaluateExpression(const QVector<int> &code, const DefineTable &table) {
+    QVector<int> stack;
+    stack.reserve(code.length());
+    bool missingOperand = false;
+    for (int i = 0; i < code.length(); i++) {
+        const int op = code.at(i);
+        if (op == ExpressionOp::PushNumber) {
+            stack.append(code.at(++i));
+        } else if (op == ExpressionOp::PushDefine) {
+            stack.append(table.values.at(code.at(++i)));
+        } else if (op == ExpressionOp::Negate || op == ExpressionOp::Complement) {
+            if (stack.isEmpty()) {
+                missingOperand = true;
+                continue;
+            }
+            stack.last() = (op == ExpressionOp::Negate) ? -stack.last() : ~stack.last();
+        } else {
+            if (stack.length() < 2) {
+                missingOperand = true;
+                continue;
+            }
+            const int op2 = stack.takeLast();
+            const int op1 = stack.takeLast();
             int result = 0;
-            if (token.value == "*") {
-                result = op1 * op2;
-            } else if (token.value == "/") {
-                result = op1 / op2;
-            } else if (token.value == "%") {
-                result = op1 % op2;
-            } else if (token.value == "+") {
-                result = op1 + op2;
-            } else if (token.value == "-") {
-                result = op1 - op2;
-            } else if (token.value == "<<") {
-                result = op1 << op2;
-            } else if (token.value == ">>") {
-                result = op1 >> op2;
-            } else if (token.value == "&") {
-                result = op1 & op2;
-            } else if (token.value == "^") {
-                result = op1 ^ op2;
-            } else if (token.value == "|") {
-                result = op1 | op2;
+            switch (op) {
+            case ExpressionOp::Multiply:   result = op1 * op2; break;
+            case ExpressionOp::Add:        result = op1 + op2; break;
+            case ExpressionOp::Subtract:   result = op1 - op2; break;
+            case ExpressionOp::LeftShift:  result = op1 << op2; break;
+            case ExpressionOp::RightShift: result = op1 >> op2; break;
+            case ExpressionOp::BitAnd:     result = op1 & op2; break;
+            case ExpressionOp::BitXor:     result = op1 ^ op2; break;
+            case ExpressionOp::BitOr:      result = op1 | op2; break;
+            case ExpressionOp::Divide:
+            case ExpressionOp::Modulo:
+                if (op2 == 0) {
+                    recordError("Division by zero detected in expression!");
+                    break;
+                }
+                result = (op == ExpressionOp::Divide) ? op1 / op2 : op1 % op2;
+                break;
             }
-            stack.push(Token(QString("%1").arg(result), "decimal"));
-        } else if (token.type != TokenClass::Error) {
-            stack.push(token);
-        } // else ignore errored tokens, we have already warned the user.
+            stack.append(result);
+        }
+    }
+    if (missingOperand) {
+        recordError("Missing operand detected in expression!");
     }
-    return stack.size() ? stack.pop().value.toInt(nullptr, 0) : 0;
+    return stack.isEmpty() ? 0 : stack.last();
 }
 
 QString ParseUtil::readCIncbin(const QString &filename, const QString &label) {
-    QString path;
-
     if (label.isNull()) {
-        return path;
-    }
-
-    this->text = readTextFile(this->root + "/" + filename);
-
-    QRegularExpression re(QString(
-        "\\b%1\\b"
-        "\\s*\\[?\\s*\\]?\\s*=\\s*"
-        "INCBIN_[US][0-9][0-9]?"
-        "\\(\\s*\"([^\"]*)\"\\s*\\)").arg(label));
-
-    QRegularExpressionMatch match;
-    qsizetype pos = this->text.indexOf(re, 0, &match);
-    if (pos != -1) {
-        path = match.captured(1);
+        return QString();
     }
-
-    return path;
+    return getLabelIndex(filename, LabelIndex::CIncbins).value(label).value(0);
 }
 
 QMap<QString, QString> ParseUtil::readCIncbinMulti(const QString &filepath) {
     QMap<QString, QString> incbinMap;
 
+    const QString fullPath = this->root + "/" + filepath;
+    if (findCachedResult(fullPath, "readCIncbinMulti", &incbinMap))
+        return incbinMap;
+
     this->file = filepath;
-    this->text = readTextFile(this->root + "/" + filepath);
+    this->text = readTextFile(fullPath);
 
     static const QRegularExpression regex("(?<label>[A-Za-z0-9_]+)\\s*\\[?\\s*\\]?\\s*=\\s*INCBIN_[US][0-9][0-9]?\\(\\s*\\\"(?<path>[^\\\\\"]*)\\\"\\s*\\)");
 
@@ -290,53 +438,90 @@ QMap<QString, QString> ParseUtil::readCIncbinMulti(const QString &filepath) {
     while (iter.hasNext()) {
         QRegularExpressionMatch match = iter.next();
         QString label = match.captured("label");
-        QString labelText = match.captured("path");
-        incbinMap[label] = labelText;
+        // Like readCIncbin, only the first definition of a label is used.
+        if (incbinMap.contains(label))
+            continue;
+        incbinMap.insert(label, match.captured("path"));
     }
 
+    this->loggedParseErrors = false;
+    cacheResult(fullPath, "readCIncbinMulti", incbinMap);
     return incbinMap;
 }
 
 QStringList ParseUtil::readCIncbinArray(const QString &filename, const QString &label) {
-    QStringList paths;
-
     if (label.isNull()) {
-        return paths;
+        return QStringList();
     }
+    return getLabelIndex(filename, LabelIndex::CIncbinArrays).value(label);
+}
 
-    this->text = readTextFile(this->root + "/" + filename);
+QMap<QString, QStringList> ParseUtil::readCIncbinArrayMulti(const QString &filename) {
+    QMap<QString, QStringList> map;
 
-    bool found = false;
-    QString arrayText;
+    const QString filepath = this->root + "/" + filename;
+    if (findCachedResult(filepath, "readCIncbinArrayMulti", &map))
+        return map;
+
+    this->file = filename;
+    this->text = readTextFile(filepath);
 
     // Get the text starting after the label all the way to the definition's end
     static const QRegularExpression re_labelGroup(QString("(?<label>[A-Za-z0-9_]+)\\[([^;]*?)};"), QRegularExpression::DotMatchesEverythingOption);
+    static const QRegularExpression re_incbin("INCBIN_[US][0-9][0-9]?\\(\\s*\"([^\"]*)\"\\s*\\)");
     QRegularExpressionMatchIterator findLabelIter = re_labelGroup.globalMatch(this->text);
     while (findLabelIter.hasNext()) {
         QRegularExpressionMatch labelMatch = findLabelIter.next();
-        if (labelMatch.captured("label") == label) {
-            found = true;
-            arrayText = labelMatch.captured(2);
-            break;
+        const QString label = labelMatch.captured("label");
+        if (map.contains(label))
+            continue;
+
+        // Extract incbin paths from the array
+        QStringList paths;
+        QRegularExpressionMatchIterator iter = re_incbin.globalMatch(labelMatch.captured(2));
+        while (iter.hasNext()) {
+            paths.append(iter.next().captured(1));
         }
+        map.insert(label, paths);
     }
 
-    if (!found) {
-        return paths;
-    }
+    this->loggedParseErrors = false;
+    cacheResult(filepath, "readCIncbinArrayMulti", map);
+    return map;
+}
 
-    // Extract incbin paths from the array
-    static const QRegularExpression re_incbin("INCBIN_[US][0-9][0-9]?\\(\\s*\"([^\"]*)\"\\s*\\)");
-    QRegularExpressionMatchIterator iter = re_incbin.globalMatch(arrayText);
-    while (iter.hasNext()) {
-        paths.append(iter.next().captured(1));
+// Returns the values of every label in the file, which are only read again if the file changes.
+// This makes it cheap to look up many labels in the same file, e.g. when reading each tileset's asset paths.
+const QMap<QString, QStringList> &ParseUtil::getLabelIndex(const QString &filename, LabelIndex type) {
+    const QFileInfo info(this->root + "/" + filename);
+    LabelIndexEntry &entry = this->labelIndexes[qMakePair(static_cast<int>(type), filename)];
+    if (entry.isValid && entry.size == info.size() && entry.lastModified == info.lastModified())
+        return entry.values;
+
+    entry.values.clear();
+    switch (type) {
+    case LabelIndex::CArrays:
+        entry.values = readCArrayMulti(filename);
+        break;
+    case LabelIndex::CIncbins: {
+        const QMap<QString, QString> incbins = readCIncbinMulti(filename);
+        for (auto it = incbins.constBegin(); it != incbins.constEnd(); it++)
+            entry.values.insert(it.key(), QStringList(it.value()));
+        break;
     }
-    return paths;
+    case LabelIndex::CIncbinArrays:
+        entry.values = readCIncbinArrayMulti(filename);
+        break;
+    }
+    entry.size = info.size();
+    entry.lastModified = info.lastModified();
+    entry.isValid = true;
+    return entry.values;
 }
 
 QMap<QString, int> ParseUtil::readCDefines(const QString &filename,
                                            const QStringList &prefixes,
-                                           QMap<QString, int> allDefines)
+                                           const QMap<QString, int> &knownDefines)
 {
     QMap<QString, int> filteredDefines;
 
@@ -347,6 +532,12 @@ QMap<QString, int> ParseUtil::readCDefines(const QString &filename,
     }
 
     QString filepath = this->root + "/" + this->file;
+    QString cacheKey = QString("readCDefines:%1").arg(prefixes.join(','));
+    for (auto it = knownDefines.constBegin(); it != knownDefines.constEnd(); it++)
+        cacheKey += QString(";%1=%2").arg(it.key()).arg(it.value());
+    if (findCachedResult(filepath, cacheKey, &filteredDefines))
+        return filteredDefines;
+
     this->text = readTextFile(filepath);
 
     if (this->text.isNull()) {
@@ -354,35 +545,100 @@ QMap<QString, int> ParseUtil::readCDefines(const QString &filename,
         return filteredDefines;
     }
 
-    static const QRegularExpression re_extraChars("(//.*)|(\\/+\\*+[^*]*\\*+\\/+)");
-    this->text.replace(re_extraChars, "");
-    static const QRegularExpression re_extraSpaces("(\\\\\\s+)");
-    this->text.replace(re_extraSpaces, "");
-    allDefines.insert("FALSE", 0);
-    allDefines.insert("TRUE", 1);
+    // Error messages are located using the text with comments and line continuations removed.
+    const QList<QPair<QString, QString>> defines = scanCDefines(this->text, &this->text);
+    DefineTable table;
+    table.knownDefines = &knownDefines;
+    table.insert("FALSE", 0);
+    table.insert("TRUE", 1);
+
+    QList<QRegularExpression> prefixFilters;
+    for (const QString &prefix : prefixes)
+        prefixFilters.append(QRegularExpression(prefix));
 
-    static const QRegularExpression re("#define\\s+(?<defineName>\\w+)[^\\S\\n]+(?<defineValue>.+)");
-    QRegularExpressionMatchIterator iter = re.globalMatch(this->text);
     this->errorMap.clear();
-    while (iter.hasNext()) {
-        QRegularExpressionMatch match = iter.next();
-        QString name = match.captured("defineName");
-        QString expression = match.captured("defineValue");
-        if (expression == " ") continue;
+    this->loggedParseErrors = false;
+    for (const auto &define : defines) {
+        const QString &name = define.first;
         this->curDefine = name;
-        int value = evaluateDefine(expression, allDefines);
-        allDefines.insert(name, value);
-        for (QString prefix : prefixes) {
-            if (name.startsWith(prefix) || QRegularExpression(prefix).match(name).hasMatch()) {
+        int value = evaluateExpression(compileExpression(define.second, table), table);
+        table.insert(name, value);
+        for (int i = 0; i < prefixes.length(); i++) {
+            if (name.startsWith(prefixes.at(i)) || prefixFilters.at(i).match(name).hasMatch()) {
                 // Only log errors for defines that Porymap is looking for
                 logRecordedErrors();
                 filteredDefines.insert(name, value);
+                break;
             }
         }
     }
+    cacheResult(filepath, cacheKey, filteredDefines);
     return filteredDefines;
 }
 
+// Reads the name and value of each '#define NAME value' in the text, in a single pass.
+// Comments are removed and continued lines are joined, and the resulting text is written to 'strippedText'.
+// Defines without a value, and function-like macros, are skipped.
+QList<QPair<QString, QString>> ParseUtil::scanCDefines(const QString &text, QString *strippedText) {
+    QList<QPair<QString, QString>> defines;
+    QString out;
+    out.reserve(text.length());
+    int lineStart = 0;
+
+    auto readDefine = [&]() {
+        const int lineEnd = out.length();
+        int pos = out.indexOf(QLatin1String("#define"), lineStart);
+        if (pos < 0)
+            return;
+        pos += 7;
+
+        const int spaceStart = pos;
+        while (pos < lineEnd && out.at(pos).isSpace()) pos++;
+        if (pos == spaceStart)
+            return;
+
+        const int nameStart = pos;
+        while (pos < lineEnd && (out.at(pos).isLetterOrNumber() || out.at(pos) == '_')) pos++;
+        const int nameEnd = pos;
+        if (nameEnd == nameStart)
+            return;
+
+        while (pos < lineEnd && out.at(pos).isSpace()) pos++;
+        if (pos == nameEnd || pos == lineEnd)
+            return;
+
+        defines.append(qMakePair(out.mid(nameStart, nameEnd - nameStart), out.mid(pos, lineEnd - pos)));
+    };
+
+    const int length = text.length();
+    for (int i = 0; i < length; i++) {
+        const QChar c = text.at(i);
+        const QChar next = (i + 1 < length) ? text.at(i + 1) : QChar();
+        if (c == '/' && next == '/') {
+            // Line comment, skip to the end of the line
+            while (i + 1 < length && text.at(i + 1) != '\n') i++;
+        } else if (c == '/' && next == '*') {
+            // Block comment, skip past its end
+            int end = text.indexOf(QLatin1String("*/"), i + 2);
+            i = (end < 0) ? length : end + 1;
+        } else if (c == '\\' && next.isSpace()) {
+            // Line continuation, join with the next line
+            while (i + 1 < length && text.at(i + 1).isSpace()) i++;
+        } else if (c == '\n') {
+            readDefine();
+            out.append(c);
+            lineStart = out.length();
+        } else {
+            out.append(c);
+        }
+    }
+    readDefine();
+
+    if (strippedText)
+        *strippedText = out;
+    return defines;
+}
+
 QStringList ParseUtil::readCDefinesSorted(const QString &filename,
                                           const QStringList &prefixes,
                                           const QMap<QString, int> &knownDefines)
@@ -399,37 +655,21 @@ QStringList ParseUtil::readCDefinesSorted(const QString &filename,
 }
 
 QStringList ParseUtil::readCArray(const QString &filename, const QString &label) {
-    QStringList list;
-
     if (label.isNull()) {
-        return list;
-    }
-
-    this->file = filename;
-    this->text = readTextFile(this->root + "/" + filename);
-
-    QRegularExpression re(QString(R"(\b%1\b\s*(\[?[^\]]*\])?\s*=\s*\{([^\}]*)\})").arg(label));
-    QRegularExpressionMatch match = re.match(this->text);
-
-    if (match.hasMatch()) {
-        QString body = match.captured(2);
-        QStringList split = body.split(',');
-        for (QString item : split) {
-            item = item.trimmed();
-            static const QRegularExpression validChars("[^A-Za-z0-9_&()\\s]");
-            if (!item.contains(validChars)) list.append(item);
-            // do not print error info here because this is called dozens of times
-        }
+        return QStringList();
     }
-
-    return list;
+    return getLabelIndex(filename, LabelIndex::CArrays).value(label);
 }
 
 QMap<QString, QStringList> ParseUtil::readCArrayMulti(const QString &filename) {
     QMap<QString, QStringList> map;
 
+    const QString filepath = this->root + "/" + filename;
+    if (findCachedResult(filepath, "readCArrayMulti", &map))
+        return map;
+
     this->file = filename;
-    this->text = readTextFile(this->root + "/" + filename);
+    this->text = readTextFile(filepath);
 
     static const QRegularExpression regex(R"((?<label>\b[A-Za-z0-9_]+\b)\s*(\[[^\]]*\])?\s*=\s*\{(?<body>[^\}]*)\})");
 
@@ -438,6 +678,9 @@ QMap<QString, QStringList> ParseUtil::readCArrayMulti(const QString &filename) {
     while (iter.hasNext()) {
         QRegularExpressionMatch match = iter.next();
         QString label = match.captured("label");
+        // Like readCArray, only the first definition of a label is used.
+        if (map.contains(label))
+            continue;
         QString body = match.captured("body");
 
         QStringList list;
@@ -451,12 +694,19 @@ QMap<QString, QStringList> ParseUtil::readCArrayMulti(const QString &filename) {
         map[label] = list;
     }
 
+    this->loggedParseErrors = false;
+    cacheResult(filepath, "readCArrayMulti", map);
     return map;
 }
 
 QMap<QString, QString> ParseUtil::readNamedIndexCArray(const QString &filename, const QString &label) {
-    this->text = readTextFile(this->root + "/" + filename);
     QMap<QString, QString> map;
+    const QString filepath = this->root + "/" + filename;
+    const QString cacheKey = QString("readNamedIndexCArray:%1").arg(label);
+    if (findCachedResult(filepath, cacheKey, &map))
+        return map;
+
+    this->text = readTextFile(filepath);
 
     QRegularExpression re_text(QString(R"(\b%1\b\s*(\[?[^\]]*\])?\s*=\s*\{([^\}]*)\})").arg(label));
     QString arrayText = re_text.match(this->text).captured(2).replace(QRegularExpression("\\s*"), "");
@@ -471,6 +721,8 @@ QMap<QString, QString> ParseUtil::readNamedIndexCArray(const QString &filename,
         map.insert(key, value);
     }
 
+    this->loggedParseErrors = false;
+    cacheResult(filepath, cacheKey, map);
     return map;
 }
 
@@ -489,10 +741,18 @@ bool ParseUtil::gameStringToBool(QString gameString, bool * ok) {
 
 QMap<QString, QHash<QString, QString>> ParseUtil::readCStructs(const QString &filename, const QString &label, const QHash<int, QString> memberMap) {
     QString filePath = this->root + "/" + filename;
+    QString cacheKey = QString("readCStructs:%1").arg(label);
+    QList<int> memberIndexes = memberMap.keys();
+    std::sort(memberIndexes.begin(), memberIndexes.end());
+    for (int i : memberIndexes)
+        cacheKey += QString(";%1=%2").arg(i).arg(memberMap.value(i));
+    QMap<QString, QHash<QString, QString>> structMaps;
+    if (findCachedResult(filePath, cacheKey, &structMaps))
+        return structMaps;
+
     auto cParser = fex::Parser();
-    auto tokens = fex::Lexer().LexFile(filePath.toStdString());
+    auto tokens = fex::Lexer().LexString(readTextFile(filePath).toStdString(), filePath.toStdString());
     auto structs = cParser.ParseTopLevelObjects(tokens);
-    QMap<QString, QHash<QString, QString>> structMaps;
     for (auto it = structs.begin(); it != structs.end(); it++) {
         QString structLabel = QString::fromStdString(it->first);
         if (structLabel.isEmpty()) continue;
@@ -513,6 +773,8 @@ QMap<QString, QHash<QString, QString>> ParseUtil::readCStructs(const QString &fi
         }
         structMaps.insert(structLabel, values);
     }
+    this->loggedParseErrors = false;
+    cacheResult(filePath, cacheKey, structMaps);
     return structMaps;
 }
 
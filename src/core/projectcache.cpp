@@ -0,0 +1,154 @@
+#include "projectcache.h"
+#include "log.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// Increase this whenever the format of the cache, or of any results stored in it, changes.
+static const quint32 cacheMagic = 0x504F5243; // "PORC"
+static const quint32 cacheVersion = 3;
+
+QString ProjectCache::getCacheFilepath(const QString &root) {
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QByteArray rootHash = QCryptographicHash::hash(QDir::cleanPath(root).toUtf8(), QCryptographicHash::Sha1);
+    return QDir(cacheDir).filePath(QString("projects/%1.cache").arg(QString(rootHash.toHex())));
+}
+
+void ProjectCache::load(const QString &root) {
+    QMutexLocker locker(&this->mutex);
+    this->files.clear();
+    this->modified = false;
+    this->cacheFilepath = getCacheFilepath(root);
+
+    QFile file(this->cacheFilepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_14);
+    quint32 magic, version;
+    in >> magic >> version;
+    if (magic != cacheMagic || version != cacheVersion) {
+        logInfo(QString("Ignoring outdated project cache '%1'").arg(this->cacheFilepath));
+        return;
+    }
+
+    quint32 numFiles;
+    in >> numFiles;
+    for (quint32 i = 0; i < numFiles && in.status() == QDataStream::Ok; i++) {
+        QString filepath;
+        FileEntry entry;
+        in >> filepath >> entry.signature.size >> entry.signature.lastModified >> entry.signature.hash >> entry.results;
+        this->files.insert(filepath, entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        logWarn(QString("Failed to read project cache '%1'").arg(this->cacheFilepath));
+        this->files.clear();
+    }
+}
+
+void ProjectCache::save() {
+    QMutexLocker locker(&this->mutex);
+    if (!this->modified || this->cacheFilepath.isEmpty())
+        return;
+
+    QDir().mkpath(QFileInfo(this->cacheFilepath).absolutePath());
+    QSaveFile file(this->cacheFilepath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        logWarn(QString("Could not open project cache '%1' for writing").arg(this->cacheFilepath));
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_14);
+    out << cacheMagic << cacheVersion << static_cast<quint32>(this->files.size());
+    for (auto it = this->files.constBegin(); it != this->files.constEnd(); it++) {
+        out << it.key() << it->signature.size << it->signature.lastModified << it->signature.hash << it->results;
+    }
+    if (file.commit()) {
+        this->modified = false;
+    } else {
+        logWarn(QString("Failed to write project cache '%1'").arg(this->cacheFilepath));
+    }
+}
+
+void ProjectCache::clear() {
+    QMutexLocker locker(&this->mutex);
+    this->files.clear();
+    this->modified = true;
+}
+
+bool ProjectCache::readSignature(const QString &filepath, FileSignature *signature, bool computeHash) {
+    QFileInfo info(filepath);
+    if (!info.isFile())
+        return false;
+    signature->size = info.size();
+    signature->lastModified = info.lastModified().toMSecsSinceEpoch();
+    if (computeHash) {
+        QFile file(filepath);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&file);
+        signature->hash = hash.result();
+    }
+    return true;
+}
+
+// Brings the file's entry up to date, dropping its results if the file's contents changed.
+// Returns false if the file can't be read.
+bool ProjectCache::validate(const QString &filepath) {
+    FileSignature current;
+    if (!readSignature(filepath, &current, false)) {
+        if (this->files.remove(filepath))
+            this->modified = true;
+        return false;
+    }
+
+    auto it = this->files.find(filepath);
+    if (it != this->files.end()
+     && it->signature.size == current.size
+     && it->signature.lastModified == current.lastModified)
+        return true;
+
+    if (!readSignature(filepath, &current, true))
+        return false;
+    this->modified = true;
+    if (it != this->files.end() && it->signature.size == current.size && it->signature.hash == current.hash) {
+        // Only the modification time changed
+        it->signature = current;
+        return true;
+    }
+    FileEntry &entry = this->files[filepath];
+    entry.signature = current;
+    entry.results.clear();
+    return true;
+}
+
+bool ProjectCache::find(const QString &filepath, const QString &key, QByteArray *out) {
+    QMutexLocker locker(&this->mutex);
+    if (!validate(filepath))
+        return false;
+
+    auto it = this->files.constFind(filepath);
+    auto result = it->results.constFind(key);
+    if (result == it->results.constEnd())
+        return false;
+    *out = result.value();
+    return true;
+}
+
+void ProjectCache::insert(const QString &filepath, const QString &key, const QByteArray &data) {
+    QMutexLocker locker(&this->mutex);
+    auto it = this->files.find(filepath);
+    if (it == this->files.end())
+        return;
+    it->results.insert(key, data);
+    this->modified = true;
+}
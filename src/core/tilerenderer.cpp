@@ -0,0 +1,146 @@
+#include "tilerenderer.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define TILERENDERER_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 path is compiled with a function-level target attribute and selected at runtime,
+// so it doesn't require building the whole project for AVX2.
+#if defined(TILERENDERER_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TILERENDERER_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef void (*DrawOpaqueTileFunc)(uint8_t *, int, const uint8_t *, const uint32_t *, bool, bool, bool);
+
+#ifndef TILERENDERER_SSE2
+void drawOpaqueTileScalar(uint8_t *dest, int destStride, const uint8_t *tilePixels, const uint32_t *palette,
+                          bool xflip, bool yflip, bool transparentColor0)
+{
+    for (int y = 0; y < 8; y++, dest += destStride) {
+        const uint8_t *src = tilePixels + (yflip ? 7 - y : y) * 8;
+        for (int x = 0; x < 8; x++) {
+            uint8_t index = src[xflip ? 7 - x : x] & 0xF;
+            if (index == 0 && transparentColor0)
+                continue;
+            memcpy(dest + x * 4, &palette[index], 4);
+        }
+    }
+}
+#endif
+
+#ifdef TILERENDERER_SSE2
+// SSE2 has no byte shuffle or gather, so the palette lookups stay scalar, but the transparency
+// test and the write to the destination are done 4 pixels at a time without branching.
+void drawOpaqueTileSSE2(uint8_t *dest, int destStride, const uint8_t *tilePixels, const uint32_t *palette,
+                        bool xflip, bool yflip, bool transparentColor0)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int y = 0; y < 8; y++, dest += destStride) {
+        const uint8_t *src = tilePixels + (yflip ? 7 - y : y) * 8;
+        uint8_t indexes[8];
+        for (int x = 0; x < 8; x++) {
+            indexes[x] = src[xflip ? 7 - x : x] & 0xF;
+        }
+        for (int half = 0; half < 2; half++) {
+            const uint8_t *idx = indexes + half * 4;
+            __m128i colors = _mm_set_epi32(palette[idx[3]], palette[idx[2]], palette[idx[1]], palette[idx[0]]);
+            __m128i *out = reinterpret_cast<__m128i *>(dest + half * 16);
+            if (transparentColor0) {
+                __m128i keep = _mm_cmpeq_epi32(_mm_set_epi32(idx[3], idx[2], idx[1], idx[0]), zero);
+                __m128i old = _mm_loadu_si128(out);
+                colors = _mm_or_si128(_mm_and_si128(keep, old), _mm_andnot_si128(keep, colors));
+            }
+            _mm_storeu_si128(out, colors);
+        }
+    }
+}
+#endif
+
+#ifdef TILERENDERER_AVX2
+// One row of a tile is exactly 8 32-bit pixels, so each row is a single gather from the palette.
+__attribute__((target("avx2")))
+void drawOpaqueTileAVX2(uint8_t *dest, int destStride, const uint8_t *tilePixels, const uint32_t *palette,
+                        bool xflip, bool yflip, bool transparentColor0)
+{
+    const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i lowNibble = _mm256_set1_epi32(0xF);
+    const __m256i zero = _mm256_setzero_si256();
+    for (int y = 0; y < 8; y++, dest += destStride) {
+        const uint8_t *src = tilePixels + (yflip ? 7 - y : y) * 8;
+        __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)));
+        indexes = _mm256_and_si256(indexes, lowNibble);
+        if (xflip)
+            indexes = _mm256_permutevar8x32_epi32(indexes, reverse);
+        __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int *>(palette), indexes, 4);
+        __m256i *out = reinterpret_cast<__m256i *>(dest);
+        if (transparentColor0) {
+            __m256i keep = _mm256_cmpeq_epi32(indexes, zero);
+            colors = _mm256_blendv_epi8(colors, _mm256_loadu_si256(out), keep);
+        }
+        _mm256_storeu_si256(out, colors);
+    }
+}
+#endif
+
+DrawOpaqueTileFunc selectDrawOpaqueTile() {
+#ifdef TILERENDERER_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return drawOpaqueTileAVX2;
+#endif
+#ifdef TILERENDERER_SSE2
+    return drawOpaqueTileSSE2;
+#else
+    return drawOpaqueTileScalar;
+#endif
+}
+
+// Blends a pixel with the given alpha over an opaque pixel. The destination stays opaque.
+inline void blendPixel(uint8_t *dest, const uint8_t *color, int alpha) {
+    for (int i = 0; i < 3; i++) {
+        dest[i] = (color[i] * alpha + dest[i] * (255 - alpha) + 127) / 255;
+    }
+}
+
+} // namespace
+
+void TileRenderer::drawTile(uint8_t *dest, int destStride, const uint8_t *tilePixels, const uint32_t *palette,
+                            bool xflip, bool yflip, bool transparentColor0, int alpha)
+{
+    if (alpha >= 255) {
+        static const DrawOpaqueTileFunc drawOpaqueTile = selectDrawOpaqueTile();
+        drawOpaqueTile(dest, destStride, tilePixels, palette, xflip, yflip, transparentColor0);
+        return;
+    }
+    if (alpha <= 0)
+        return;
+
+    // Translucent layers are only used for previews, so they don't get a vectorized path.
+    for (int y = 0; y < 8; y++, dest += destStride) {
+        const uint8_t *src = tilePixels + (yflip ? 7 - y : y) * 8;
+        for (int x = 0; x < 8; x++) {
+            uint8_t index = src[xflip ? 7 - x : x] & 0xF;
+            if (index == 0 && transparentColor0)
+                continue;
+            blendPixel(dest + x * 4, reinterpret_cast<const uint8_t *>(&palette[index]), alpha);
+        }
+    }
+}
+
+void TileRenderer::fillTile(uint8_t *dest, int destStride, uint32_t color) {
+    for (int y = 0; y < 8; y++, dest += destStride) {
+        for (int x = 0; x < 8; x++) {
+            memcpy(dest + x * 4, &color, 4);
+        }
+    }
+}
+
+void TileRenderer::blit(uint8_t *dest, int destStride, const uint8_t *src, int srcStride, int width, int height) {
+    for (int y = 0; y < height; y++, dest += destStride, src += srcStride) {
+        memcpy(dest, src, width * 4);
+    }
+}
@@ -20,15 +20,12 @@ Tileset::Tileset(const Tileset &other)
       tilesImagePath(other.tilesImagePath),
       tilesImage(other.tilesImage.copy()),
       palettePaths(other.palettePaths),
+      tilePixels(other.tilePixels),
       metatileLabels(other.metatileLabels),
       palettes(other.palettes),
       palettePreviews(other.palettePreviews),
       hasUnsavedTilesImage(false)
 {
-    for (auto tile : other.tiles) {
-        tiles.append(tile.copy());
-    }
-
     for (auto *metatile : other.metatiles) {
         metatiles.append(new Metatile(*metatile));
     }
@@ -49,17 +46,15 @@ Tileset &Tileset::operator=(const Tileset &other) {
     metatileLabels = other.metatileLabels;
     palettes = other.palettes;
     palettePreviews = other.palettePreviews;
-
-    tiles.clear();
-    for (auto tile : other.tiles) {
-        tiles.append(tile.copy());
-    }
+    tilePixels = other.tilePixels;
 
     metatiles.clear();
     for (auto *metatile : other.metatiles) {
         metatiles.append(new Metatile(*metatile));
     }
 
+    metatileImageCache.clear();
+
     return *this;
 }
 
@@ -92,6 +87,49 @@ Metatile* Tileset::getMetatile(int metatileId, Tileset *primaryTileset, Tileset
     return tileset->metatiles.value(index, nullptr);
 }
 
+// Returns the palette indices for the pixels of the specified tile, or nullptr if the tile doesn't exist.
+const uchar* Tileset::getTilePixels(int tileId, Tileset *primaryTileset, Tileset *secondaryTileset) {
+    Tileset *tileset = Tileset::getTileTileset(tileId, primaryTileset, secondaryTileset);
+    if (!tileset) {
+        return nullptr;
+    }
+    return tileset->getTilePixels(Tile::getIndexInTileset(tileId));
+}
+
+const uchar* Tileset::getTilePixels(int index) const {
+    if (index < 0 || index >= this->numTiles()) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uchar *>(this->tilePixels.constData()) + index * pixelsPerTile;
+}
+
+// Split an indexed tiles image into 8x8 tiles, read left-to-right and top-to-bottom.
+void Tileset::setTilePixels(const QImage &image) {
+    QImage indexedImage = image;
+    if (indexedImage.format() != QImage::Format_Indexed8)
+        indexedImage = indexedImage.convertToFormat(QImage::Format_Indexed8);
+
+    int numTilesWide = (indexedImage.width() + tileWidth - 1) / tileWidth;
+    int numTilesHigh = (indexedImage.height() + tileHeight - 1) / tileHeight;
+    QByteArray pixels(numTilesWide * numTilesHigh * pixelsPerTile, 0);
+    uchar *dest = reinterpret_cast<uchar *>(pixels.data());
+    for (int tileY = 0; tileY < numTilesHigh; tileY++)
+    for (int tileX = 0; tileX < numTilesWide; tileX++) {
+        for (int y = tileY * tileHeight; y < (tileY + 1) * tileHeight; y++, dest += tileWidth) {
+            // Tiles that extend past the edge of the image are padded with color 0
+            if (y >= indexedImage.height())
+                continue;
+            const uchar *src = indexedImage.constScanLine(y);
+            for (int x = 0; x < tileWidth; x++) {
+                int imageX = tileX * tileWidth + x;
+                if (imageX < indexedImage.width())
+                    dest[x] = src[imageX];
+            }
+        }
+    }
+    this->tilePixels = pixels;
+}
+
 // Metatile labels are stored per-tileset. When looking for a metatile label, first search in the tileset
 // that the metatile belongs to. If one isn't found, search in the other tileset. Labels coming from the
 // tileset that the metatile does not belong to are shared and cannot be edited via Porymap.
@@ -628,6 +628,8 @@ bool Editor::setMap(QString map_name) {
         }
 
         map = loadedMap;
+        project->loadMapEvents(map);
+        project->prefetchConnectedTilesets(map);
 
         editGroup.addStack(&map->editHistory);
         editGroup.setActiveStack(&map->editHistory);
@@ -639,6 +641,7 @@ bool Editor::setMap(QString map_name) {
         connect(map, &Map::mapDimensionsChanged, map_ruler, &MapRuler::setMapDimensions);
         connect(map, &Map::openScriptRequested, this, &Editor::openScript);
         updateSelectedEvents();
+        project->mapPrefetcher->prefetchNeighbors(map);
     }
 
     return true;
@@ -705,6 +708,8 @@ void Editor::mouseEvent_map(QGraphicsSceneMouseEvent *event, MapPixmapItem *item
         return;
     }
 
+    // Scripts are told about all of the blocks changed by this mouse event at once.
+    ScriptBlockChangeBatch scriptBatch;
     QPoint pos = Metatile::coordFromPixmapCoord(event->pos());
 
     if (item->paintingMode == MapPixmapItem::PaintMode::Metatiles) {
@@ -817,6 +822,7 @@ void Editor::mouseEvent_collision(QGraphicsSceneMouseEvent *event, CollisionPixm
         return;
     }
 
+    ScriptBlockChangeBatch scriptBatch;
     QPoint pos = Metatile::coordFromPixmapCoord(event->pos());
 
     if (map_edit_mode == "paint") {
@@ -945,8 +951,8 @@ void Editor::displayMapMetatiles() {
     scene->setSceneRect(
         -BORDER_DISTANCE * tw,
         -BORDER_DISTANCE * th,
-        map_item->pixmap().width() + BORDER_DISTANCE * 2 * tw,
-        map_item->pixmap().height() + BORDER_DISTANCE * 2 * th
+        map_item->boundingRect().width() + BORDER_DISTANCE * 2 * tw,
+        map_item->boundingRect().height() + BORDER_DISTANCE * 2 * th
     );
 }
 
@@ -1069,11 +1075,17 @@ void Editor::displayMapConnections() {
     }
     selected_connection_item = nullptr;
     connection_items.clear();
+    pending_connections.clear();
 
     for (MapConnection *connection : map->connections) {
         if (connection->direction == "dive" || connection->direction == "emerge") {
             continue;
         }
+        // Don't wait for the connected map's tilesets, it's displayed once they're loaded.
+        if (project->isMapWaitingForTilesets(connection->map_name)) {
+            pending_connections.append(connection);
+            continue;
+        }
         createConnectionItem(connection);
     }
 
@@ -1084,6 +1096,39 @@ void Editor::displayMapConnections() {
     maskNonVisibleConnectionTiles();
 }
 
+// Displays the connections that were waiting for their maps' tilesets to load, once they have.
+void Editor::displayPendingConnections() {
+    if (!project || !map || pending_connections.isEmpty()) {
+        return;
+    }
+
+    bool displayed = false;
+    for (int i = 0; i < pending_connections.length();) {
+        MapConnection *connection = pending_connections.at(i);
+        if (!map->connections.contains(connection)) {
+            pending_connections.removeAt(i);
+        } else if (!project->isMapWaitingForTilesets(connection->map_name)) {
+            pending_connections.removeAt(i);
+            createConnectionItem(connection);
+            displayed = true;
+        } else {
+            i++;
+        }
+    }
+    if (!displayed) {
+        return;
+    }
+
+    // Match the items that were created when the map was displayed (see setEditingMap, setEditingConnections, etc.)
+    const bool editingConnections = map_item && map_item->paintingMode == MapPixmapItem::PaintMode::Disabled;
+    setConnectionItemsVisible(editingConnections || ui->checkBox_ToggleBorder->isChecked());
+    setConnectionsEditable(editingConnections);
+    if (!selected_connection_item && !connection_items.empty()) {
+        onConnectionItemSelected(connection_items.first());
+    }
+    maskNonVisibleConnectionTiles();
+}
+
 void Editor::createConnectionItem(MapConnection* connection) {
     Map *connected_map = project->getMap(connection->map_name);
     if (!connected_map) {
@@ -1347,6 +1392,7 @@ void Editor::updateMirroredConnection(MapConnection* connection, QString origina
     if (isDelete) {
         if (mirrorConnection) {
             otherMap->connections.removeOne(mirrorConnection);
+            otherMap->hasUnsavedDataChanges = true;
             delete mirrorConnection;
         }
         return;
@@ -1355,6 +1401,7 @@ void Editor::updateMirroredConnection(MapConnection* connection, QString origina
     if (connection->direction != originalDirection || connection->map_name != originalMapName) {
         if (mirrorConnection) {
             otherMap->connections.removeOne(mirrorConnection);
+            otherMap->hasUnsavedDataChanges = true;
             delete mirrorConnection;
             mirrorConnection = nullptr;
             otherMap = project->getMap(connection->map_name);
@@ -1370,6 +1417,8 @@ void Editor::updateMirroredConnection(MapConnection* connection, QString origina
     }
 
     mirrorConnection->offset = -connection->offset;
+    // The connected map must not be evicted from the map cache before this is saved.
+    otherMap->hasUnsavedDataChanges = true;
 }
 
 void Editor::removeCurrentConnection() {
@@ -0,0 +1,250 @@
+#include "headlessrunner.h"
+#include "project.h"
+#include "config.h"
+#include "log.h"
+#include "map.h"
+#include "events.h"
+#include "scriptworker.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QPainter>
+#include <QTextStream>
+#include <cstring>
+
+bool HeadlessRunner::isRequested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+    return false;
+}
+
+void HeadlessRunner::printUsage() {
+    QTextStream(stderr)
+        << "Usage: porymap --headless [--events] <project> <command> [arguments...]\n"
+        << "\n"
+        << "Commands:\n"
+        << "  export-map <map> <output.png>        Save an image of a map.\n"
+        << "  export-stitched <map> <output.png>   Save an image of a map and all the maps connected to it.\n"
+        << "  resave                               Load and save every map and layout in the project.\n"
+        << "  run-script <script.js> <function> [map...]\n"
+        << "                                       Run a function exported by a script, with access to the given\n"
+        << "                                       maps (all maps if none are given) through the 'worker' object.\n"
+        << "                                       Maps it edits are saved. Its return value is printed as JSON.\n"
+        << "\n"
+        << "Options:\n"
+        << "  --events   Draw events in exported map images.\n";
+}
+
+int HeadlessRunner::run(const QStringList &arguments) {
+    QCoreApplication::setOrganizationName("pret");
+    QCoreApplication::setApplicationName("porymap");
+
+    QCommandLineParser parser;
+    parser.addOption(QCommandLineOption("headless"));
+    parser.addOption(QCommandLineOption("events"));
+    parser.parse(arguments);
+    const QStringList args = parser.positionalArguments();
+    if (args.length() < 2) {
+        printUsage();
+        return 2;
+    }
+    this->drawEvents = parser.isSet("events");
+
+    porymapConfig.load();
+    if (!this->openProject(args.at(0)))
+        return 1;
+
+    int result;
+    const QString command = args.at(1);
+    const QStringList commandArgs = args.mid(2);
+    if (command == "export-map") {
+        result = this->exportMapImage(commandArgs);
+    } else if (command == "export-stitched") {
+        result = this->exportStitchedMapImage(commandArgs);
+    } else if (command == "resave") {
+        result = this->resaveAll();
+    } else if (command == "run-script") {
+        result = this->runScript(commandArgs);
+    } else {
+        logError(QString("Unknown command '%1'").arg(command));
+        printUsage();
+        result = 2;
+    }
+
+    delete this->project;
+    this->project = nullptr;
+    return result;
+}
+
+// Opens the project the same way as MainWindow::openProject, without any of the UI.
+bool HeadlessRunner::openProject(const QString &dir) {
+    const QString root = QDir(dir).absolutePath();
+    if (!QDir(root).exists()) {
+        logError(QString("Project directory '%1' doesn't exist.").arg(QDir::toNativeSeparators(root)));
+        return false;
+    }
+
+    userConfig.setProjectDir(root);
+    userConfig.load();
+    projectConfig.setProjectDir(root);
+    projectConfig.setInteractive(false);
+    projectConfig.load();
+
+    this->project = new Project();
+    this->project->set_root(root);
+    if (!this->project->readDataStructures() || !this->project->readMapGroups()) {
+        logError(QString("Failed to open project '%1'. See %2 for full error details.")
+                 .arg(QDir::toNativeSeparators(root))
+                 .arg(getLogPath()));
+        return false;
+    }
+    logInfo(QString("Opened project %1").arg(QDir::toNativeSeparators(root)));
+    return true;
+}
+
+Map *HeadlessRunner::getMap(const QString &mapName) {
+    if (!this->project->mapNames.contains(mapName)) {
+        logError(QString("Unknown map '%1'").arg(mapName));
+        return nullptr;
+    }
+    Map *map = this->project->getMap(mapName);
+    if (!map)
+        logError(QString("Failed to load map '%1'").arg(mapName));
+    return map;
+}
+
+QImage HeadlessRunner::renderMap(Map *map) {
+    QImage image = map->render(true).toImage();
+    if (this->drawEvents) {
+        this->project->loadMapEvents(map);
+        QPainter painter(&image);
+        for (Event *event : map->getAllEvents()) {
+            this->project->setEventPixmap(event);
+            painter.drawImage(QPoint(event->getPixelX(), event->getPixelY()), event->getPixmap().toImage());
+        }
+        painter.end();
+    }
+    return image;
+}
+
+int HeadlessRunner::exportMapImage(const QStringList &args) {
+    if (args.length() != 2) {
+        printUsage();
+        return 2;
+    }
+    Map *map = this->getMap(args.at(0));
+    if (!map)
+        return 1;
+
+    if (!this->renderMap(map).save(args.at(1))) {
+        logError(QString("Failed to save map image '%1'").arg(args.at(1)));
+        return 1;
+    }
+    logInfo(QString("Saved image of map '%1' to '%2'").arg(map->name).arg(args.at(1)));
+    return 0;
+}
+
+// Same layout as the stitched image in MapImageExporter, without borders.
+int HeadlessRunner::exportStitchedMapImage(const QStringList &args) {
+    if (args.length() != 2) {
+        printUsage();
+        return 2;
+    }
+    Map *startMap = this->getMap(args.at(0));
+    if (!startMap)
+        return 1;
+
+    const QList<StitchedMap> stitchedMaps = this->project->getStitchedMaps(startMap);
+    const QRect bounds = Project::getStitchedBounds(stitchedMaps);
+
+    QImage image(bounds.width() * 16, bounds.height() * 16, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    for (const StitchedMap &stitchedMap : stitchedMaps) {
+        painter.drawImage((stitchedMap.x - bounds.left()) * 16, (stitchedMap.y - bounds.top()) * 16, this->renderMap(stitchedMap.map));
+    }
+    painter.end();
+    this->project->trimCachesKeeping({});
+
+    if (!image.save(args.at(1))) {
+        logError(QString("Failed to save stitched map image '%1'").arg(args.at(1)));
+        return 1;
+    }
+    logInfo(QString("Saved stitched image of %1 maps to '%2'").arg(stitchedMaps.length()).arg(args.at(1)));
+    return 0;
+}
+
+int HeadlessRunner::resaveAll() {
+    // Each map is saved as soon as it's loaded, so the map cache can be trimmed as it goes.
+    int numFailed = 0;
+    for (const QString &mapName : this->project->mapNames) {
+        Map *map = this->project->getMap(mapName);
+        if (!map) {
+            logError(QString("Failed to load map '%1'").arg(mapName));
+            numFailed++;
+            continue;
+        }
+        this->project->saveMap(map);
+        this->project->trimCachesKeeping({});
+    }
+    this->project->saveAllDataStructures();
+    logInfo(QString("Saved %1 maps").arg(this->project->mapNames.length() - numFailed));
+    return numFailed ? 1 : 0;
+}
+
+int HeadlessRunner::runScript(const QStringList &args) {
+    if (args.length() < 2) {
+        printUsage();
+        return 2;
+    }
+    const QString filepath = QDir(QDir::currentPath()).absoluteFilePath(args.at(0));
+    const QStringList mapNames = args.length() > 2 ? args.mid(2) : this->project->mapNames;
+
+    ScriptWorker worker(filepath, args.at(1), QVariant(), this->project->root);
+    for (const QString &mapName : mapNames) {
+        Map *map = this->getMap(mapName);
+        if (!map)
+            return 1;
+        // The worker keeps its own copy of the map, so the map itself doesn't need to stay loaded.
+        worker.addMap(map);
+        this->project->trimCachesKeeping({});
+    }
+
+    // There's no event loop in headless mode, so progress is logged directly from the worker's thread.
+    QObject::connect(&worker, &ScriptWorker::progressChanged, [](double progress, QString message) {
+        logInfo(QString("Script progress: %1% %2").arg(qRound(progress * 100)).arg(message));
+    });
+    worker.start();
+    worker.wait();
+
+    if (!worker.getError().isEmpty()) {
+        logError(worker.getError());
+        return 1;
+    }
+
+    const QStringList changedMapNames = worker.applyChanges(this->project, nullptr);
+    for (const QString &mapName : changedMapNames) {
+        this->project->saveMap(this->project->getMap(mapName));
+    }
+    if (!changedMapNames.isEmpty()) {
+        this->project->saveAllDataStructures();
+        logInfo(QString("Saved script edits to %1 maps").arg(changedMapNames.length()));
+    }
+
+    const QJsonValue result = QJsonValue::fromVariant(worker.getResult());
+    if (result.isObject()) {
+        QTextStream(stdout) << QJsonDocument(result.toObject()).toJson(QJsonDocument::Compact) << "\n";
+    } else if (result.isArray()) {
+        QTextStream(stdout) << QJsonDocument(result.toArray()).toJson(QJsonDocument::Compact) << "\n";
+    } else if (!result.isNull() && !result.isUndefined()) {
+        QTextStream(stdout) << result.toVariant().toString() << "\n";
+    }
+    return 0;
+}
@@ -155,9 +155,9 @@ namespace fex
         return Token(Token::Type::kDefine, filename_, line_number_);
     }
 
-    std::vector<Token> Lexer::LexString(const std::string &data)
+    std::vector<Token> Lexer::LexString(const std::string &data, const std::string &filename)
     {
-        filename_ = "string literal";
+        filename_ = filename;
         line_number_ = 1;
         index_ = 0;
         data_ = data;
@@ -1,6 +1,7 @@
 #include "log.h"
 #include <QDateTime>
 #include <QDir>
+#include <QMutex>
 #include <QStandardPaths>
 #include <QSysInfo>
 
@@ -28,8 +29,13 @@ void logWarn(QString message) {
 
 static QString mostRecentError;
 
+// Messages may be logged from worker threads, e.g. while a project is loading.
+static QMutex logMutex;
+
 void logError(QString message) {
+    QMutexLocker locker(&logMutex);
     mostRecentError = message;
+    locker.unlock();
     log(message, LogType::LOG_ERROR);
 }
 
@@ -68,6 +74,7 @@ void log(QString message, LogType type) {
 
     message = QString("%1 %2 %3").arg(now).arg(typeString).arg(message);
 
+    QMutexLocker locker(&logMutex);
     qDebug().noquote() << colorizeMessage(message, type);
     QFile outFile(getLogPath());
     outFile.open(QIODevice::WriteOnly | QIODevice::Append);
@@ -84,6 +91,7 @@ QString getLogPath() {
 }
 
 QString getMostRecentError() {
+    QMutexLocker locker(&logMutex);
     return mostRecentError;
 }
 
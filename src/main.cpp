@@ -1,10 +1,23 @@
 #include "mainwindow.h"
+#include "headlessrunner.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Headless mode has no window, so on Linux it falls back to the offscreen platform when there's no display (e.g. in CI).
+    // Everywhere else, the normal platform is used.
+    const bool headless = HeadlessRunner::isRequested(argc, argv);
+#if defined(Q_OS_UNIX) && !defined(Q_OS_MACOS)
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")
+     && qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+
     QGuiApplication::setHighDpiScaleFactorRoundingPolicy(Qt::HighDpiScaleFactorRoundingPolicy::Round);
     QApplication a(argc, argv);
+    if (headless)
+        return HeadlessRunner().run(a.arguments());
+
     a.setStyle("fusion");
     MainWindow w(nullptr);
     w.show();
@@ -513,7 +513,10 @@ bool MainWindow::openProject(QString dir) {
         editor->closeProject();
         editor->project = new Project(this);
         QObject::connect(editor->project, &Project::reloadProject, this, &MainWindow::on_action_Reload_Project_triggered);
+        QObject::connect(editor->project, &Project::dataReloaded, this, &MainWindow::onProjectDataReloaded);
         QObject::connect(editor->project, &Project::mapCacheCleared, this, &MainWindow::onMapCacheCleared);
+        // Queued, because tilesets can finish loading in the middle of loading a map.
+        QObject::connect(editor->project, &Project::tilesetLoaded, editor, &Editor::displayPendingConnections, Qt::QueuedConnection);
         QObject::connect(editor->project, &Project::disableWildEncountersUI, [this]() { this->setWildEncountersUIEnabled(false); });
         QObject::connect(editor->project, &Project::uncheckMonitorFilesAction, [this]() {
             porymapConfig.setMonitorFiles(false);
@@ -632,6 +635,20 @@ void MainWindow::on_action_Reload_Project_triggered() {
     }
 }
 
+// Some of the project's data was re-read after its files changed, so refresh everything that displays it.
+void MainWindow::onProjectDataReloaded() {
+    loadProjectCombos();
+    displayMapProperties();
+    Scripting::populateGlobalObject(this);
+    if (editor->map) {
+        for (Event *event : editor->map->getAllEvents())
+            editor->project->setEventPixmap(event, true);
+        editor->displayMapEvents();
+        updateSelectedObjects();
+        editor->displayWildMonTables();
+    }
+}
+
 bool MainWindow::setMap(QString map_name, bool scrollTreeView) {
     logInfo(QString("Setting map to '%1'").arg(map_name));
     if (map_name.isEmpty()) {
@@ -671,9 +688,23 @@ bool MainWindow::setMap(QString map_name, bool scrollTreeView) {
     Scripting::cb_MapOpened(map_name);
     prefab.updatePrefabUi(editor->map);
     updateTilesetEditor();
+    trimMapCache();
     return true;
 }
 
+// Evicts maps that haven't been used recently once the map cache grows too large.
+// The open map, the maps it's connected to, and the map in the image exporter are kept.
+void MainWindow::trimMapCache() {
+    if (!editor->project || !editor->map)
+        return;
+
+    QList<Map*> keepMaps = {editor->map};
+    if (this->mapImageExporter) {
+        keepMaps.append(this->mapImageExporter->getMap());
+    }
+    editor->project->trimCachesKeeping(keepMaps);
+}
+
 void MainWindow::redrawMapScene()
 {
     if (!editor->displayMap())
@@ -900,36 +931,7 @@ void MainWindow::on_spinBox_FloorNumber_valueChanged(int offset)
 }
 
 bool MainWindow::loadDataStructures() {
-    Project *project = editor->project;
-    bool success = project->readMapLayouts()
-                && project->readRegionMapSections()
-                && project->readItemNames()
-                && project->readFlagNames()
-                && project->readVarNames()
-                && project->readMovementTypes()
-                && project->readInitialFacingDirections()
-                && project->readMapTypes()
-                && project->readMapBattleScenes()
-                && project->readWeatherNames()
-                && project->readCoordEventWeatherNames()
-                && project->readSecretBaseIds() 
-                && project->readBgEventFacingDirections()
-                && project->readTrainerTypes()
-                && project->readMetatileBehaviors()
-                && project->readTilesetProperties()
-                && project->readTilesetLabels()
-                && project->readTilesetMetatileLabels()
-                && project->readMaxMapDataSize()
-                && project->readHealLocations()
-                && project->readMiscellaneousConstants()
-                && project->readSpeciesIconPaths()
-                && project->readWildMonData()
-                && project->readEventScriptLabels()
-                && project->readObjEventGfxConstants()
-                && project->readEventGraphics()
-                && project->readSongNames();
-
-    Metatile::setCustomLayout(project);
+    bool success = editor->project->readDataStructures();
     Scripting::populateGlobalObject(this);
 
     return success && loadProjectCombos();
@@ -20,6 +20,9 @@
 #include <QStandardItem>
 #include <QMessageBox>
 #include <QRegularExpression>
+#include <QThread>
+#include <QThreadStorage>
+#include <QtConcurrent>
 #include <algorithm>
 
 using OrderedJson = poryjson::Json;
@@ -40,6 +43,7 @@ Project::Project(QWidget *parent) :
     eventScriptLabelModel(this),
     eventScriptLabelCompleter(this)
 {
+    this->mapPrefetcher = new MapPrefetcher(this);
     initSignals();
 }
 
@@ -47,12 +51,15 @@ Project::~Project()
 {
     clearMapCache();
     clearTilesetCache();
+    cache.save();
+    ParseUtil::clearTextFileCache();
 }
 
 void Project::initSignals() {
     // detect changes to specific filepaths being monitored
     QObject::connect(&fileWatcher, &QFileSystemWatcher::fileChanged, [this](QString changed){
-        if (!porymapConfig.getMonitorFiles()) return;
+        // Projects opened without a window (e.g. in headless mode) have no one to ask.
+        if (!porymapConfig.getMonitorFiles() || !this->parentWidget()) return;
         if (modifiedFileTimestamps.contains(changed)) {
             if (QDateTime::currentMSecsSinceEpoch() < modifiedFileTimestamps[changed]) {
                 return;
@@ -60,6 +67,9 @@ void Project::initSignals() {
             modifiedFileTimestamps.remove(changed);
         }
 
+        // Files often change in bulk (e.g. when the project is built), so changes that
+        // arrive while the user is being asked are handled along with the first one.
+        changedFiles.insert(changed);
         static bool showing = false;
         if (showing) return;
 
@@ -76,8 +86,11 @@ void Project::initSignals() {
 
         showing = true;
         int choice = notice.exec();
+        const QStringList filepaths = changedFiles.values();
+        changedFiles.clear();
         if (choice == QMessageBox::Yes) {
-            emit reloadProject();
+            if (!reloadChangedFiles(filepaths))
+                emit reloadProject();
         } else if (choice == QMessageBox::No) {
             if (showAgainCheck.isChecked()) {
                 porymapConfig.setMonitorFiles(false);
@@ -88,10 +101,95 @@ void Project::initSignals() {
     });
 }
 
+const QList<QList<Project::DataReader>> &Project::getDataReaderChains() {
+    static const QList<QList<DataReader>> chains = {
+        {&Project::readMapLayouts},
+        {&Project::readRegionMapSections},
+        {&Project::readItemNames},
+        {&Project::readFlagNames},
+        {&Project::readVarNames},
+        {&Project::readMovementTypes},
+        {&Project::readInitialFacingDirections},
+        {&Project::readMapTypes},
+        {&Project::readMapBattleScenes},
+        {&Project::readWeatherNames},
+        // Both can disable an event type, which saves the project config, so they can't run at the same time.
+        {&Project::readCoordEventWeatherNames, &Project::readSecretBaseIds},
+        {&Project::readBgEventFacingDirections},
+        {&Project::readTrainerTypes},
+        {&Project::readMetatileBehaviors},
+        {&Project::readTilesetProperties, &Project::readMaxMapDataSize},
+        {&Project::readTilesetLabels, &Project::readTilesetMetatileLabels},
+        {&Project::readHealLocations},
+        {&Project::readMiscellaneousConstants, &Project::readWildMonData},
+        {&Project::readSpeciesIconPaths},
+        {&Project::readObjEventGfxConstants, &Project::readEventGraphics},
+        {&Project::readSongNames},
+    };
+    return chains;
+}
+
+// The reader running on each thread, so the files it watches can be associated with it.
+static QThreadStorage<Project::DataReader> currentDataReader;
+
+bool Project::runDataReader(DataReader reader) {
+    currentDataReader.setLocalData(reader);
+    bool success = (this->*reader)();
+    currentDataReader.setLocalData(nullptr);
+    return success;
+}
+
+// Re-runs only the readers that use the given files, along with the readers that depend on them.
+// Returns false if the project needs to be reloaded entirely instead.
+bool Project::reloadChangedFiles(const QStringList &filepaths) {
+    // Maps, layouts and tilesets are built from this data when they're loaded,
+    // so changes to it can't be applied without reloading them.
+    static const QList<DataReader> structuralReaders = {
+        &Project::readMapLayouts,
+        &Project::readTilesetLabels,
+        &Project::readTilesetProperties,
+        &Project::readMaxMapDataSize,
+        &Project::readHealLocations,
+    };
+
+    // Tilesets being loaded in the background may be reading the data that's about to change.
+    publishPendingTilesets();
+
+    QList<DataReader> changedReaders;
+    for (const auto &filepath : filepaths) {
+        ParseUtil::invalidateTextFile(filepath);
+        const QList<DataReader> readers = this->fileReaders.value(filepath);
+        if (readers.isEmpty())
+            return false;
+        for (const auto &reader : readers) {
+            if (structuralReaders.contains(reader))
+                return false;
+            changedReaders.append(reader);
+        }
+    }
+
+    for (const auto &chain : getDataReaderChains()) {
+        for (int i = 0; i < chain.length(); i++) {
+            if (!changedReaders.contains(chain.at(i)))
+                continue;
+            for (int j = i; j < chain.length(); j++) {
+                if (!runDataReader(chain.at(j)))
+                    logWarn("Failed to reload project data. The project may need to be reloaded.");
+            }
+            break;
+        }
+    }
+    logInfo(QString("Reloaded project data from %1 changed file(s)").arg(filepaths.length()));
+    emit dataReloaded();
+    return true;
+}
+
 void Project::set_root(QString dir) {
     this->root = dir;
     this->importExportPath = dir;
     this->parser.set_root(dir);
+    this->cache.load(dir);
+    this->parser.setCache(&this->cache);
 }
 
 QString Project::getProjectTitle() {
@@ -108,15 +206,268 @@ void Project::clearMapCache() {
             delete map;
     }
     mapCache.clear();
+    mapLastUsed.clear();
+    clearPrefetchedMapFiles();
     emit mapCacheCleared();
 }
 
 void Project::clearTilesetCache() {
+    publishPendingTilesets();
     for (auto *tileset : tilesetCache.values()) {
         if (tileset)
             delete tileset;
     }
     tilesetCache.clear();
+    tilesetLastUsed.clear();
+}
+
+static qint64 getPixmapBytes(const QPixmap &pixmap) {
+    return static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
+qint64 Project::getRenderBufferBytes(const Map *map) {
+    return map->image.sizeInBytes() + getPixmapBytes(map->pixmap)
+         + map->collision_image.sizeInBytes() + getPixmapBytes(map->collision_pixmap);
+}
+
+qint64 Project::getLayoutBytes(const MapLayout *layout) {
+    // The layout's other copies of its blocks are usually shared with these, so they aren't counted.
+    qint64 numBlocks = layout->blockdata.size() + layout->border.size();
+    return numBlocks * static_cast<qint64>(sizeof(Block))
+         + layout->border_image.sizeInBytes() + getPixmapBytes(layout->border_pixmap);
+}
+
+qint64 Project::getTilesetBytes(const Tileset *tileset) {
+    const qint64 metatileImageBytes = 16 * 16 * 4;
+    return tileset->tilesImage.sizeInBytes() + tileset->tilePixels.size()
+         + tileset->metatiles.size() * static_cast<qint64>(sizeof(Metatile))
+         + tileset->metatileImageCache.size() * metatileImageBytes;
+}
+
+// Maps with unsaved changes or undo history are kept, as are maps that are in use (e.g. the open map).
+bool Project::canEvictMap(Map *map, const QSet<Map*> &keepMaps) {
+    return map
+        && !keepMaps.contains(map)
+        && map->isPersistedToFile
+        && !map->hasUnsavedChanges()
+        && map->editHistory.count() == 0;
+}
+
+// Discards the map's rendered images, they'll be redrawn if the map is displayed again.
+qint64 Project::releaseRenderBuffers(Map *map) {
+    qint64 bytes = getRenderBufferBytes(map);
+    map->image = QImage();
+    map->pixmap = QPixmap();
+    map->collision_image = QImage();
+    map->collision_pixmap = QPixmap();
+    return bytes;
+}
+
+// Removes the map from the cache. Its layout's blocks are also discarded, unless another cached or kept map uses the layout.
+// Returns roughly how much memory was freed.
+qint64 Project::evictMap(Map *map, const QSet<Map*> &keepMaps) {
+    qint64 bytes = releaseRenderBuffers(map);
+    mapCache.remove(map->name);
+    mapLastUsed.remove(map->name);
+
+    MapLayout *layout = map->layout;
+    bool layoutInUse = !layout;
+    for (Map *other : mapCache.values() + keepMaps.values()) {
+        if (other && other->layout == layout) {
+            layoutInUse = true;
+            break;
+        }
+    }
+    if (!layoutInUse) {
+        bytes += getLayoutBytes(layout);
+        layout->blockdata.clear();
+        layout->border.clear();
+        layout->cached_border.clear();
+        layout->lastCommitBlocks.blocks.clear();
+        layout->lastCommitBlocks.border.clear();
+        layout->border_image = QImage();
+        layout->border_pixmap = QPixmap();
+    }
+
+    qDeleteAll(map->connections);
+    map->connections.clear();
+    delete map;
+    numEvictedMaps++;
+    return bytes;
+}
+
+// Removes the tileset from the cache. It must not be used by any cached map.
+qint64 Project::evictTileset(const QString &label) {
+    Tileset *tileset = tilesetCache.take(label);
+    tilesetLastUsed.remove(label);
+    if (!tileset)
+        return 0;
+
+    // Layouts that aren't loaded may still point to the tileset. They'll get it from the cache again when they're loaded.
+    for (MapLayout *layout : mapLayouts.values()) {
+        if (layout->tileset_primary == tileset)
+            layout->tileset_primary = nullptr;
+        if (layout->tileset_secondary == tileset)
+            layout->tileset_secondary = nullptr;
+    }
+
+    qint64 bytes = getTilesetBytes(tileset);
+    delete tileset;
+    numEvictedTilesets++;
+    return bytes;
+}
+
+// Evicts the least recently used maps and tilesets until the caches fit in the configured memory budget.
+// This deletes cached maps, so it should only be called when nothing outside of the project is holding
+// a pointer to a map that isn't in 'keepMaps' (e.g. after a new map was opened).
+void Project::trimCaches(const QSet<Map*> &keepMaps) {
+    const qint64 budget = static_cast<qint64>(porymapConfig.getMapCacheMemoryBudget()) * 1024 * 1024;
+
+    QSet<MapLayout*> cachedLayouts;
+    qint64 usedBytes = 0;
+    for (Map *map : mapCache.values()) {
+        usedBytes += getRenderBufferBytes(map);
+        if (map->layout && !cachedLayouts.contains(map->layout)) {
+            cachedLayouts.insert(map->layout);
+            usedBytes += getLayoutBytes(map->layout);
+        }
+    }
+    for (Tileset *tileset : tilesetCache.values()) {
+        usedBytes += getTilesetBytes(tileset);
+    }
+    if (usedBytes <= budget)
+        return;
+
+    const qint64 startBytes = usedBytes;
+    const int startEvictedMaps = numEvictedMaps;
+    const int startEvictedTilesets = numEvictedTilesets;
+
+    QList<Map*> candidates;
+    for (Map *map : mapCache.values()) {
+        if (canEvictMap(map, keepMaps))
+            candidates.append(map);
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](Map *a, Map *b) {
+        return mapLastUsed.value(a->name) < mapLastUsed.value(b->name);
+    });
+
+    // Rendered images are the largest part of a map and the cheapest to recreate, so they go first.
+    for (Map *map : candidates) {
+        if (usedBytes <= budget)
+            break;
+        usedBytes -= releaseRenderBuffers(map);
+    }
+    while (usedBytes > budget && !candidates.isEmpty()) {
+        usedBytes -= evictMap(candidates.takeFirst(), keepMaps);
+    }
+
+    if (usedBytes > budget) {
+        QSet<QString> usedTilesets;
+        for (Map *map : mapCache.values() + keepMaps.values()) {
+            if (map && map->layout) {
+                usedTilesets.insert(map->layout->tileset_primary_label);
+                usedTilesets.insert(map->layout->tileset_secondary_label);
+            }
+        }
+        QStringList unusedTilesets;
+        for (const QString &label : tilesetCache.keys()) {
+            if (!usedTilesets.contains(label))
+                unusedTilesets.append(label);
+        }
+        std::sort(unusedTilesets.begin(), unusedTilesets.end(), [this](const QString &a, const QString &b) {
+            return tilesetLastUsed.value(a) < tilesetLastUsed.value(b);
+        });
+        for (const QString &label : unusedTilesets) {
+            if (usedBytes <= budget)
+                break;
+            usedBytes -= evictTileset(label);
+        }
+    }
+
+    logInfo(QString("Trimmed map cache from %1 KB to %2 KB (budget %3 KB): evicted %4 maps and %5 tilesets, "
+                    "%6 maps and %7 tilesets remain cached (%8 maps and %9 tilesets evicted this session)")
+            .arg(startBytes / 1024)
+            .arg(usedBytes / 1024)
+            .arg(budget / 1024)
+            .arg(numEvictedMaps - startEvictedMaps)
+            .arg(numEvictedTilesets - startEvictedTilesets)
+            .arg(mapCache.size())
+            .arg(tilesetCache.size())
+            .arg(numEvictedMaps)
+            .arg(numEvictedTilesets));
+}
+
+// Trims the caches (see trimCaches) after something that may have loaded many maps, e.g. opening a map or exporting
+// a stitched map image. The given maps and the loaded maps they're connected to are kept.
+void Project::trimCachesKeeping(const QList<Map*> &maps) {
+    QSet<Map*> keepMaps;
+    for (Map *map : maps) {
+        if (!map)
+            continue;
+        keepMaps.insert(map);
+        for (const MapConnection *connection : map->connections) {
+            keepMaps.insert(mapCache.value(connection->map_name));
+        }
+    }
+    keepMaps.remove(nullptr);
+    trimCaches(keepMaps);
+}
+
+// Finds the maps that can be reached from 'startMap' through their connections, except dive and emerge connections,
+// along with their positions for drawing them all in one image (see MapImageExporter and HeadlessRunner).
+// 'onProgress' is called with the number of maps visited and found so far, and can return false to cancel.
+QList<StitchedMap> Project::getStitchedMaps(Map *startMap, const std::function<bool(int, int)> &onProgress) {
+    // Do a breadth-first search to gather a collection of
+    // all reachable maps with their relative offsets.
+    QSet<QString> visited;
+    QList<StitchedMap> stitchedMaps;
+    QList<StitchedMap> unvisited;
+    unvisited.append(StitchedMap{0, 0, startMap});
+    while (!unvisited.isEmpty()) {
+        if (onProgress && !onProgress(visited.size(), visited.size() + unvisited.size()))
+            return QList<StitchedMap>();
+
+        StitchedMap cur = unvisited.takeFirst();
+        if (visited.contains(cur.map->name))
+            continue;
+        visited.insert(cur.map->name);
+        stitchedMaps.append(cur);
+
+        for (MapConnection *connection : cur.map->connections) {
+            if (connection->direction == "dive" || connection->direction == "emerge")
+                continue;
+            Map *connectionMap = getMap(connection->map_name);
+            if (!connectionMap)
+                continue;
+            int x = cur.x;
+            int y = cur.y;
+            int offset = connection->offset;
+            if (connection->direction == "up") {
+                x += offset;
+                y -= connectionMap->getHeight();
+            } else if (connection->direction == "down") {
+                x += offset;
+                y += cur.map->getHeight();
+            } else if (connection->direction == "left") {
+                x -= connectionMap->getWidth();
+                y += offset;
+            } else if (connection->direction == "right") {
+                x += cur.map->getWidth();
+                y += offset;
+            }
+            unvisited.append(StitchedMap{x, y, connectionMap});
+        }
+    }
+    return stitchedMaps;
+}
+
+// Returns the area covered by the stitched maps, in metatiles.
+QRect Project::getStitchedBounds(const QList<StitchedMap> &stitchedMaps) {
+    QRect bounds;
+    for (const StitchedMap &stitchedMap : stitchedMaps) {
+        bounds |= QRect(stitchedMap.x, stitchedMap.y, stitchedMap.map->getWidth(), stitchedMap.map->getHeight());
+    }
+    return bounds;
 }
 
 Map* Project::loadMap(QString map_name) {
@@ -136,6 +487,7 @@ Map* Project::loadMap(QString map_name) {
         return nullptr;
 
     mapCache.insert(map_name, map);
+    mapLastUsed.insert(map_name, ++cacheUseCounter);
     return map;
 }
 
@@ -182,15 +534,14 @@ bool Project::loadMapData(Map* map) {
         return true;
     }
 
-    QString mapFilepath = QString("%1/%3%2/map.json").arg(root).arg(map->name).arg(projectConfig.getFilePath(ProjectFilePath::data_map_folders));
-    QJsonDocument mapDoc;
-    if (!parser.tryParseJsonFile(&mapDoc, mapFilepath)) {
-        logError(QString("Failed to read map data from %1").arg(mapFilepath));
+    publishPendingMapJson(map->name);
+    QJsonObject mapObj;
+    if (prefetchedMapJson.contains(map->name)) {
+        mapObj = prefetchedMapJson.take(map->name);
+    } else if (!readMapJson(map->name, &mapObj)) {
         return false;
     }
 
-    QJsonObject mapObj = mapDoc.object();
-
     map->song          = ParseUtil::jsonToQString(mapObj["music"]);
     map->layoutId      = ParseUtil::jsonToQString(mapObj["layout"]);
     map->location      = ParseUtil::jsonToQString(mapObj["region_map_section"]);
@@ -211,108 +562,13 @@ bool Project::loadMapData(Map* map) {
     map->sharedEventsMap  = ParseUtil::jsonToQString(mapObj["shared_events_map"]);
     map->sharedScriptsMap = ParseUtil::jsonToQString(mapObj["shared_scripts_map"]);
 
-    // Events
-    map->events[Event::Group::Object].clear();
-    QJsonArray objectEventsArr = mapObj["object_events"].toArray();
-    bool hasCloneObjects = projectConfig.getEventCloneObjectEnabled();
-    for (int i = 0; i < objectEventsArr.size(); i++) {
-        QJsonObject event = objectEventsArr[i].toObject();
-        // If clone objects are not enabled then no type field is present
-        QString type = hasCloneObjects ? ParseUtil::jsonToQString(event["type"]) : "object";
-        if (type.isEmpty() || type == "object") {
-            ObjectEvent *object = new ObjectEvent();
-            object->loadFromJson(event, this);
-            map->addEvent(object);
-        } else if (type == "clone") {
-            CloneObjectEvent *clone = new CloneObjectEvent();
-            if (clone->loadFromJson(event, this)) {
-                map->addEvent(clone);
-            }
-            else {
-                delete clone;
-            }
-        } else {
-            logError(QString("Map %1 object_event %2 has invalid type '%3'. Must be 'object' or 'clone'.").arg(map->name).arg(i).arg(type));
-        }
-    }
-
-    map->events[Event::Group::Warp].clear();
-    QJsonArray warpEventsArr = mapObj["warp_events"].toArray();
-    for (int i = 0; i < warpEventsArr.size(); i++) {
-        QJsonObject event = warpEventsArr[i].toObject();
-        WarpEvent *warp = new WarpEvent();
-        if (warp->loadFromJson(event, this)) {
-            map->addEvent(warp);
-        }
-        else {
-            delete warp;
-        }
-    }
-
-    map->events[Event::Group::Coord].clear();
-    QJsonArray coordEventsArr = mapObj["coord_events"].toArray();
-    for (int i = 0; i < coordEventsArr.size(); i++) {
-        QJsonObject event = coordEventsArr[i].toObject();
-        QString type = ParseUtil::jsonToQString(event["type"]);
-        if (type == "trigger") {
-            TriggerEvent *coord = new TriggerEvent();
-            coord->loadFromJson(event, this);
-            map->addEvent(coord);
-        } else if (type == "weather") {
-            WeatherTriggerEvent *coord = new WeatherTriggerEvent();
-            coord->loadFromJson(event, this);
-            map->addEvent(coord);
-        } else {
-            logError(QString("Map %1 coord_event %2 has invalid type '%3'. Must be 'trigger' or 'weather'.").arg(map->name).arg(i).arg(type));
-        }
-    }
-
-    map->events[Event::Group::Bg].clear();
-    QJsonArray bgEventsArr = mapObj["bg_events"].toArray();
-    for (int i = 0; i < bgEventsArr.size(); i++) {
-        QJsonObject event = bgEventsArr[i].toObject();
-        QString type = ParseUtil::jsonToQString(event["type"]);
-        if (type == "sign") {
-            SignEvent *bg = new SignEvent();
-            bg->loadFromJson(event, this);
-            map->addEvent(bg);
-        } else if (type == "hidden_item") {
-            HiddenItemEvent *bg = new HiddenItemEvent();
-            bg->loadFromJson(event, this);
-            map->addEvent(bg);
-        } else if (type == "secret_base") {
-            SecretBaseEvent *bg = new SecretBaseEvent();
-            bg->loadFromJson(event, this);
-            map->addEvent(bg);
-        } else {
-            logError(QString("Map %1 bg_event %2 has invalid type '%3'. Must be 'sign', 'hidden_item', or 'secret_base'.").arg(map->name).arg(i).arg(type));
-        }
-    }
-
-    map->events[Event::Group::Heal].clear();
-    for (auto it = healLocations.begin(); it != healLocations.end(); it++) {
-        HealLocation loc = *it;
-        //if TRUE map is flyable / has healing location
-        if (loc.mapName == QString(mapNamesToMapConstants.value(map->name)).remove(0,4)) {
-            HealLocationEvent *heal = new HealLocationEvent();
-            heal->setMap(map);
-            heal->setX(loc.x);
-            heal->setY(loc.y);
-            heal->setElevation(3);
-            heal->setLocationName(loc.mapName);
-            heal->setIdName(loc.idName);
-            heal->setIndex(loc.index);
-
-            // TODO: what is this
-            // heal->put("destination_map_name", mapConstantsToMapNames.value(map->name));
-
-            if (projectConfig.getHealLocationRespawnDataEnabled()) {
-                heal->setRespawnMap(mapConstantsToMapNames.value(QString("MAP_" + loc.respawnMap)));
-                heal->setRespawnNPC(loc.respawnNPC);
-            }
-            map->events[Event::Group::Heal].append(heal);
-        }
+    // Events are only created once they're needed (see loadMapEvents), because most maps
+    // that get loaded are only needed for their layout and connections.
+    map->eventsJson = QJsonObject();
+    for (const QString &key : {"object_events", "warp_events", "coord_events", "bg_events"}) {
+        map->eventsJson.insert(key, mapObj[key]);
     }
+    map->eventsLoaded = false;
 
     map->connections.clear();
     QJsonArray connectionsArr = mapObj["connections"].toArray();
@@ -343,10 +599,32 @@ bool Project::loadMapData(Map* map) {
     return true;
 }
 
+bool Project::readMapJson(const QString &mapName, QJsonObject *mapObj) {
+    QString mapFilepath = QString("%1/%3%2/map.json").arg(root).arg(mapName).arg(projectConfig.getFilePath(ProjectFilePath::data_map_folders));
+    QJsonDocument mapDoc;
+    if (!threadParser().tryParseJsonFile(&mapDoc, mapFilepath)) {
+        logError(QString("Failed to read map data from %1").arg(mapFilepath));
+        return false;
+    }
+    *mapObj = mapDoc.object();
+    return true;
+}
+
+// Returns the layout of a map whose map.json was read ahead of loading it, or nullptr if it wasn't.
+MapLayout *Project::getPrefetchedMapLayout(const QString &mapName) const {
+    auto it = prefetchedMapJson.constFind(mapName);
+    if (it == prefetchedMapJson.constEnd())
+        return nullptr;
+    return mapLayouts.value(ParseUtil::jsonToQString(it.value()["layout"]));
+}
+
 QString Project::readMapLayoutId(QString map_name) {
     if (mapCache.contains(map_name)) {
         return mapCache.value(map_name)->layoutId;
     }
+    if (prefetchedMapJson.contains(map_name)) {
+        return ParseUtil::jsonToQString(prefetchedMapJson.value(map_name)["layout"]);
+    }
 
     QString mapFilepath = QString("%1/%3%2/map.json").arg(root).arg(map_name).arg(projectConfig.getFilePath(ProjectFilePath::data_map_folders));
     QJsonDocument mapDoc;
@@ -411,9 +689,9 @@ bool Project::readMapLayouts() {
 
     QString layoutsFilepath = projectConfig.getFilePath(ProjectFilePath::json_layouts);
     QString fullFilepath = QString("%1/%2").arg(root).arg(layoutsFilepath);
-    fileWatcher.addPath(fullFilepath);
+    watchFile(fullFilepath);
     QJsonDocument layoutsDoc;
-    if (!parser.tryParseJsonFile(&layoutsDoc, fullFilepath)) {
+    if (!threadParser().tryParseJsonFile(&layoutsDoc, fullFilepath)) {
         logError(QString("Failed to read map layouts from %1").arg(fullFilepath));
         return false;
     }
@@ -448,7 +726,7 @@ bool Project::readMapLayouts() {
         QJsonObject layoutObj = layouts[i].toObject();
         if (layoutObj.isEmpty())
             continue;
-        if (!parser.ensureFieldsExist(layoutObj, requiredFields)) {
+        if (!threadParser().ensureFieldsExist(layoutObj, requiredFields)) {
             logError(QString("Layout %1 is missing field(s) in %2.").arg(i).arg(layoutsFilepath));
             return false;
         }
@@ -579,6 +857,44 @@ void Project::saveMapLayouts() {
     layoutsFile.close();
 }
 
+// The read* functions may be run on worker threads while the project is loading (see MainWindow::loadDataStructures).
+// Watched files are associated with the reader that watched them, so only that reader needs to run when they change.
+// The file watcher belongs to the main thread, so paths watched from other threads are added once control returns to it.
+void Project::watchFile(const QString &filepath) {
+    watchFiles(QStringList(filepath));
+}
+
+void Project::watchFiles(const QStringList &filepaths) {
+    DataReader reader = currentDataReader.hasLocalData() ? currentDataReader.localData() : nullptr;
+    if (reader) {
+        QMutexLocker locker(&this->fileReadersMutex);
+        for (const auto &filepath : filepaths) {
+            QList<DataReader> &readers = this->fileReaders[filepath];
+            if (!readers.contains(reader))
+                readers.append(reader);
+        }
+    }
+    if (QThread::currentThread() == this->thread()) {
+        fileWatcher.addPaths(filepaths);
+    } else {
+        QMetaObject::invokeMethod(this, [this, filepaths] { fileWatcher.addPaths(filepaths); }, Qt::QueuedConnection);
+    }
+}
+
+// ParseUtil keeps state about the file it's parsing, so each worker thread gets its own.
+ParseUtil &Project::threadParser() {
+    if (QThread::currentThread() == this->thread())
+        return this->parser;
+
+    static QThreadStorage<ParseUtil *> parsers;
+    if (!parsers.hasLocalData())
+        parsers.setLocalData(new ParseUtil());
+    ParseUtil *parser = parsers.localData();
+    parser->set_root(this->root);
+    parser->setCache(&this->cache);
+    return *parser;
+}
+
 void Project::ignoreWatchedFileTemporarily(QString filepath) {
     // Ignore any file-change events for this filepath for the next 5 seconds.
     modifiedFileTimestamps.insert(filepath, QDateTime::currentMSecsSinceEpoch() + 5000);
@@ -1017,6 +1333,9 @@ void Project::saveTilesetPalettes(Tileset *tileset) {
 }
 
 bool Project::loadLayoutTilesets(MapLayout *layout) {
+    // Decode the secondary tileset in the background while the primary tileset loads.
+    prefetchTileset(layout->tileset_secondary_label);
+
     layout->tileset_primary = getTileset(layout->tileset_primary_label);
     if (!layout->tileset_primary) {
         QString defaultTileset = this->getDefaultPrimaryTilesetLabel();
@@ -1044,10 +1363,19 @@ bool Project::loadLayoutTilesets(MapLayout *layout) {
 }
 
 Tileset* Project::loadTileset(QString label, Tileset *tileset) {
+    tileset = readTileset(label, tileset);
+    if (tileset) {
+        tilesetCache.insert(label, tileset);
+    }
+    return tileset;
+}
+
+// Reads the tileset's header and assets. This may be called from any thread, so it doesn't touch the tileset cache.
+Tileset* Project::readTileset(const QString &label, Tileset *tileset) {
     auto memberMap = Tileset::getHeaderMemberMap(this->usingAsmTilesets);
     if (this->usingAsmTilesets) {
         // Read asm tileset header. Backwards compatibility
-        const QStringList values = parser.getLabelValues(parser.parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_headers_asm)), label);
+        const QStringList values = threadParser().getLabelValues(threadParser().parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_headers_asm)), label);
         if (values.isEmpty()) {
             return nullptr;
         }
@@ -1062,7 +1390,7 @@ Tileset* Project::loadTileset(QString label, Tileset *tileset) {
         tileset->metatile_attrs_label = values.value(memberMap.key("metatileAttributes"));
     } else {
         // Read C tileset header
-        const auto structs = parser.readCStructs(projectConfig.getFilePath(ProjectFilePath::tilesets_headers), label, memberMap);
+        const auto structs = threadParser().readCStructs(projectConfig.getFilePath(ProjectFilePath::tilesets_headers), label, memberMap);
         if (!structs.contains(label)) {
             return nullptr;
         }
@@ -1079,8 +1407,6 @@ Tileset* Project::loadTileset(QString label, Tileset *tileset) {
     }
 
     loadTilesetAssets(tileset);
-
-    tilesetCache.insert(label, tileset);
     return tileset;
 }
 
@@ -1163,6 +1489,10 @@ void Project::saveLayoutBlockdata(Map* map) {
 }
 
 void Project::writeBlockdata(QString path, const Blockdata &blockdata) {
+    // Blocks read ahead of loading the layout are out of date now.
+    publishPendingBlockdata(path);
+    prefetchedBlockdata.remove(path);
+
     QFile file(path);
     if (file.open(QIODevice::WriteOnly)) {
         QByteArray data = blockdata.serialize();
@@ -1178,6 +1508,8 @@ void Project::saveAllMaps() {
 }
 
 void Project::saveMap(Map *map) {
+    loadMapEvents(map);
+
     // Create/Modify a few collateral files for brand new maps.
     QString basePath = projectConfig.getFilePath(ProjectFilePath::data_map_folders);
     QString mapDataDir = root + "/" + basePath + map->name;
@@ -1368,13 +1700,13 @@ void Project::readTilesetPaths(Tileset* tileset) {
     const QString rootDir = this->root + "/";
     if (this->usingAsmTilesets) {
         // Read asm tileset data files. Backwards compatibility
-        const QList<QStringList> graphics = parser.parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_graphics_asm));
-        const QList<QStringList> metatiles_macros = parser.parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_metatiles_asm));
+        const QList<QStringList> graphics = threadParser().parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_graphics_asm));
+        const QList<QStringList> metatiles_macros = threadParser().parseAsm(projectConfig.getFilePath(ProjectFilePath::tilesets_metatiles_asm));
 
-        const QStringList tiles_values = parser.getLabelValues(graphics, tileset->tiles_label);
-        const QStringList palettes_values = parser.getLabelValues(graphics, tileset->palettes_label);
-        const QStringList metatiles_values = parser.getLabelValues(metatiles_macros, tileset->metatiles_label);
-        const QStringList metatile_attrs_values = parser.getLabelValues(metatiles_macros, tileset->metatile_attrs_label);
+        const QStringList tiles_values = threadParser().getLabelValues(graphics, tileset->tiles_label);
+        const QStringList palettes_values = threadParser().getLabelValues(graphics, tileset->palettes_label);
+        const QStringList metatiles_values = threadParser().getLabelValues(metatiles_macros, tileset->metatiles_label);
+        const QStringList metatile_attrs_values = threadParser().getLabelValues(metatiles_macros, tileset->metatile_attrs_label);
 
         if (!tiles_values.isEmpty())
             tileset->tilesImagePath = this->fixGraphicPath(rootDir + tiles_values.value(0).section('"', 1, 1));
@@ -1389,10 +1721,10 @@ void Project::readTilesetPaths(Tileset* tileset) {
         const QString graphicsFile = projectConfig.getFilePath(ProjectFilePath::tilesets_graphics);
         const QString metatilesFile = projectConfig.getFilePath(ProjectFilePath::tilesets_metatiles);
         
-        const QString tilesImagePath = parser.readCIncbin(graphicsFile, tileset->tiles_label);
-        const QStringList palettePaths = parser.readCIncbinArray(graphicsFile, tileset->palettes_label);
-        const QString metatilesPath = parser.readCIncbin(metatilesFile, tileset->metatiles_label);
-        const QString metatileAttrsPath = parser.readCIncbin(metatilesFile, tileset->metatile_attrs_label);
+        const QString tilesImagePath = threadParser().readCIncbin(graphicsFile, tileset->tiles_label);
+        const QStringList palettePaths = threadParser().readCIncbinArray(graphicsFile, tileset->palettes_label);
+        const QString metatilesPath = threadParser().readCIncbin(metatilesFile, tileset->metatiles_label);
+        const QString metatileAttrsPath = threadParser().readCIncbin(metatilesFile, tileset->metatile_attrs_label);
 
         if (!tilesImagePath.isEmpty())
             tileset->tilesImagePath = this->fixGraphicPath(rootDir + tilesImagePath);
@@ -1441,16 +1773,8 @@ void Project::loadTilesetPalettes(Tileset* tileset) {
 }
 
 void Project::loadTilesetTiles(Tileset *tileset, QImage image) {
-    QList<QImage> tiles;
-    int w = 8;
-    int h = 8;
-    for (int y = 0; y < image.height(); y += h)
-    for (int x = 0; x < image.width(); x += w) {
-        QImage tile = image.copy(x, y, w, h);
-        tiles.append(tile);
-    }
     tileset->tilesImage = image;
-    tileset->tiles = tiles;
+    tileset->setTilePixels(image);
 }
 
 void Project::loadTilesetMetatiles(Tileset* tileset) {
@@ -1504,9 +1828,9 @@ bool Project::readTilesetMetatileLabels() {
     metatileLabelsMap.clear();
 
     QString metatileLabelsFilename = projectConfig.getFilePath(ProjectFilePath::constants_metatile_labels);
-    fileWatcher.addPath(root + "/" + metatileLabelsFilename);
+    watchFile(root + "/" + metatileLabelsFilename);
 
-    QMap<QString, int> labels = parser.readCDefines(metatileLabelsFilename, QStringList() << "METATILE_");
+    QMap<QString, int> labels = threadParser().readCDefines(metatileLabelsFilename, QStringList() << "METATILE_");
 
     for (QString tilesetLabel : this->tilesetLabelsOrdered) {
         QString metatileLabelPrefix = Tileset::getMetatileLabelPrefix(tilesetLabel);
@@ -1524,13 +1848,23 @@ void Project::loadTilesetMetatileLabels(Tileset* tileset) {
     QString metatileLabelPrefix = tileset->getMetatileLabelPrefix();
 
     // Reverse map for faster lookup by metatile id
-    for (QString labelName : metatileLabelsMap[tileset->name].keys()) {
-        int metatileId = metatileLabelsMap[tileset->name][labelName];
-        tileset->metatileLabels[metatileId] = labelName.replace(metatileLabelPrefix, "");
+    const QMap<QString, int> labels = metatileLabelsMap.value(tileset->name);
+    for (auto it = labels.constBegin(); it != labels.constEnd(); it++) {
+        QString labelName = it.key();
+        tileset->metatileLabels[it.value()] = labelName.replace(metatileLabelPrefix, "");
     }
 }
 
 Blockdata Project::readBlockdata(QString path) {
+    publishPendingBlockdata(path);
+    if (prefetchedBlockdata.contains(path)) {
+        return prefetchedBlockdata.take(path);
+    }
+    return readBlockdataFile(path);
+}
+
+// Doesn't use any of the project's data, so it can be called from any thread.
+Blockdata Project::readBlockdataFile(const QString &path) {
     Blockdata blockdata;
     QFile file(path);
     if (file.open(QIODevice::ReadOnly)) {
@@ -1546,8 +1880,121 @@ Blockdata Project::readBlockdata(QString path) {
     return blockdata;
 }
 
+// Creates the events of a map whose data was loaded by loadMapData. Does nothing if they already exist.
+void Project::loadMapEvents(Map *map) {
+    if (!map || map->eventsLoaded) {
+        return;
+    }
+
+    map->events[Event::Group::Object].clear();
+    QJsonArray objectEventsArr = map->eventsJson["object_events"].toArray();
+    bool hasCloneObjects = projectConfig.getEventCloneObjectEnabled();
+    for (int i = 0; i < objectEventsArr.size(); i++) {
+        QJsonObject event = objectEventsArr[i].toObject();
+        // If clone objects are not enabled then no type field is present
+        QString type = hasCloneObjects ? ParseUtil::jsonToQString(event["type"]) : "object";
+        if (type.isEmpty() || type == "object") {
+            ObjectEvent *object = new ObjectEvent();
+            object->loadFromJson(event, this);
+            map->addEvent(object);
+        } else if (type == "clone") {
+            CloneObjectEvent *clone = new CloneObjectEvent();
+            if (clone->loadFromJson(event, this)) {
+                map->addEvent(clone);
+            }
+            else {
+                delete clone;
+            }
+        } else {
+            logError(QString("Map %1 object_event %2 has invalid type '%3'. Must be 'object' or 'clone'.").arg(map->name).arg(i).arg(type));
+        }
+    }
+
+    map->events[Event::Group::Warp].clear();
+    QJsonArray warpEventsArr = map->eventsJson["warp_events"].toArray();
+    for (int i = 0; i < warpEventsArr.size(); i++) {
+        QJsonObject event = warpEventsArr[i].toObject();
+        WarpEvent *warp = new WarpEvent();
+        if (warp->loadFromJson(event, this)) {
+            map->addEvent(warp);
+        }
+        else {
+            delete warp;
+        }
+    }
+
+    map->events[Event::Group::Coord].clear();
+    QJsonArray coordEventsArr = map->eventsJson["coord_events"].toArray();
+    for (int i = 0; i < coordEventsArr.size(); i++) {
+        QJsonObject event = coordEventsArr[i].toObject();
+        QString type = ParseUtil::jsonToQString(event["type"]);
+        if (type == "trigger") {
+            TriggerEvent *coord = new TriggerEvent();
+            coord->loadFromJson(event, this);
+            map->addEvent(coord);
+        } else if (type == "weather") {
+            WeatherTriggerEvent *coord = new WeatherTriggerEvent();
+            coord->loadFromJson(event, this);
+            map->addEvent(coord);
+        } else {
+            logError(QString("Map %1 coord_event %2 has invalid type '%3'. Must be 'trigger' or 'weather'.").arg(map->name).arg(i).arg(type));
+        }
+    }
+
+    map->events[Event::Group::Bg].clear();
+    QJsonArray bgEventsArr = map->eventsJson["bg_events"].toArray();
+    for (int i = 0; i < bgEventsArr.size(); i++) {
+        QJsonObject event = bgEventsArr[i].toObject();
+        QString type = ParseUtil::jsonToQString(event["type"]);
+        if (type == "sign") {
+            SignEvent *bg = new SignEvent();
+            bg->loadFromJson(event, this);
+            map->addEvent(bg);
+        } else if (type == "hidden_item") {
+            HiddenItemEvent *bg = new HiddenItemEvent();
+            bg->loadFromJson(event, this);
+            map->addEvent(bg);
+        } else if (type == "secret_base") {
+            SecretBaseEvent *bg = new SecretBaseEvent();
+            bg->loadFromJson(event, this);
+            map->addEvent(bg);
+        } else {
+            logError(QString("Map %1 bg_event %2 has invalid type '%3'. Must be 'sign', 'hidden_item', or 'secret_base'.").arg(map->name).arg(i).arg(type));
+        }
+    }
+
+    map->events[Event::Group::Heal].clear();
+    for (auto it = healLocations.begin(); it != healLocations.end(); it++) {
+        HealLocation loc = *it;
+        //if TRUE map is flyable / has healing location
+        if (loc.mapName == QString(mapNamesToMapConstants.value(map->name)).remove(0,4)) {
+            HealLocationEvent *heal = new HealLocationEvent();
+            heal->setMap(map);
+            heal->setX(loc.x);
+            heal->setY(loc.y);
+            heal->setElevation(3);
+            heal->setLocationName(loc.mapName);
+            heal->setIdName(loc.idName);
+            heal->setIndex(loc.index);
+
+            // TODO: what is this
+            // heal->put("destination_map_name", mapConstantsToMapNames.value(map->name));
+
+            if (projectConfig.getHealLocationRespawnDataEnabled()) {
+                heal->setRespawnMap(mapConstantsToMapNames.value(QString("MAP_" + loc.respawnMap)));
+                heal->setRespawnNPC(loc.respawnNPC);
+            }
+            map->events[Event::Group::Heal].append(heal);
+        }
+    }
+
+    map->eventsJson = QJsonObject();
+    map->eventsLoaded = true;
+}
+
 Map* Project::getMap(QString map_name) {
     if (mapCache.contains(map_name)) {
+        mapLastUsed.insert(map_name, ++cacheUseCounter);
         return mapCache.value(map_name);
     } else {
         Map *map = loadMap(map_name);
@@ -1556,10 +2003,13 @@ Map* Project::getMap(QString map_name) {
 }
 
 Tileset* Project::getTileset(QString label, bool forceLoad) {
+    publishPendingTileset(label);
+
     Tileset *existingTileset = nullptr;
     if (tilesetCache.contains(label)) {
         existingTileset = tilesetCache.value(label);
     }
+    tilesetLastUsed.insert(label, ++cacheUseCounter);
 
     if (existingTileset && !forceLoad) {
         return existingTileset;
@@ -1569,7 +2019,171 @@ Tileset* Project::getTileset(QString label, bool forceLoad) {
     }
 }
 
+// Starts loading the tileset on a worker thread, if it isn't loaded already.
+// Decoding a tileset's images and palettes is slow, so this should be called for tilesets that are likely to be needed soon.
+void Project::prefetchTileset(const QString &label) {
+    if (label.isEmpty() || this->tilesetCache.contains(label) || this->pendingTilesets.contains(label)) {
+        return;
+    }
+
+    auto watcher = new QFutureWatcher<Tileset*>(this);
+    connect(watcher, &QFutureWatcher<Tileset*>::finished, this, [this, label] {
+        publishPendingTileset(label);
+    });
+    this->pendingTilesets.insert(label, watcher);
+    watcher->setFuture(QtConcurrent::run([this, label] {
+        return readTileset(label, nullptr);
+    }));
+}
+
+// Starts loading the tilesets needed to display the map's connections.
+// The connected maps' map.json files are kept for when the maps are loaded (see loadMapData), so they're only read once.
+void Project::prefetchConnectedTilesets(Map *map) {
+    if (!map) {
+        return;
+    }
+    for (MapConnection *connection : map->connections) {
+        const QString mapName = connection->map_name;
+        if (connection->direction == "dive" || connection->direction == "emerge"
+         || this->mapCache.contains(mapName) || !this->mapNames.contains(mapName)) {
+            continue;
+        }
+        if (!this->prefetchedMapJson.contains(mapName)) {
+            QJsonObject mapObj;
+            if (!readMapJson(mapName, &mapObj)) {
+                continue;
+            }
+            this->prefetchedMapJson.insert(mapName, mapObj);
+        }
+        MapLayout *layout = getPrefetchedMapLayout(mapName);
+        if (layout) {
+            prefetchTileset(layout->tileset_primary_label);
+            prefetchTileset(layout->tileset_secondary_label);
+        }
+    }
+}
+
+// Starts reading the map's map.json on a worker thread, if it isn't loaded or read already.
+// Once it's finished, the map's layout can be found with getPrefetchedMapLayout.
+void Project::prefetchMapJson(const QString &mapName) {
+    if (this->mapCache.contains(mapName) || this->prefetchedMapJson.contains(mapName) || this->pendingMapJson.contains(mapName)) {
+        return;
+    }
+
+    auto watcher = new QFutureWatcher<QJsonObject>(this);
+    connect(watcher, &QFutureWatcher<QJsonObject>::finished, this, [this, mapName] {
+        publishPendingMapJson(mapName);
+    });
+    this->pendingMapJson.insert(mapName, watcher);
+    watcher->setFuture(QtConcurrent::run([this, mapName] {
+        QJsonObject mapObj;
+        readMapJson(mapName, &mapObj);
+        return mapObj;
+    }));
+}
+
+// Waits for the map's map.json to finish being read if it's being read in the background, then keeps it for loadMapData.
+void Project::publishPendingMapJson(const QString &mapName) {
+    QFutureWatcher<QJsonObject> *watcher = this->pendingMapJson.take(mapName);
+    if (!watcher) {
+        return;
+    }
+
+    watcher->waitForFinished();
+    const QJsonObject mapObj = watcher->result();
+    watcher->deleteLater();
+    if (!mapObj.isEmpty() && !this->mapCache.contains(mapName)) {
+        this->prefetchedMapJson.insert(mapName, mapObj);
+    }
+}
+
+// Starts reading the layout's blockdata and border on a worker thread. They're used the next time the layout is loaded.
+void Project::prefetchLayoutBlockdata(MapLayout *layout) {
+    if (!layout) {
+        return;
+    }
+    for (const QString &filepath : {layout->blockdata_path, layout->border_path}) {
+        const QString path = QString("%1/%2").arg(this->root).arg(filepath);
+        if (this->prefetchedBlockdata.contains(path) || this->pendingBlockdata.contains(path)) {
+            continue;
+        }
+        auto watcher = new QFutureWatcher<Blockdata>(this);
+        connect(watcher, &QFutureWatcher<Blockdata>::finished, this, [this, path] {
+            publishPendingBlockdata(path);
+        });
+        this->pendingBlockdata.insert(path, watcher);
+        watcher->setFuture(QtConcurrent::run([path] {
+            return readBlockdataFile(path);
+        }));
+    }
+}
+
+bool Project::isLayoutBlockdataLoading(const MapLayout *layout) const {
+    return layout && (this->pendingBlockdata.contains(QString("%1/%2").arg(this->root).arg(layout->blockdata_path))
+                   || this->pendingBlockdata.contains(QString("%1/%2").arg(this->root).arg(layout->border_path)));
+}
+
+void Project::publishPendingBlockdata(const QString &path) {
+    QFutureWatcher<Blockdata> *watcher = this->pendingBlockdata.take(path);
+    if (!watcher) {
+        return;
+    }
+
+    watcher->waitForFinished();
+    this->prefetchedBlockdata.insert(path, watcher->result());
+    watcher->deleteLater();
+}
+
+// Discards the map files that were read ahead of loading their maps, e.g. because the project is being reloaded.
+void Project::clearPrefetchedMapFiles() {
+    for (const QString &mapName : this->pendingMapJson.keys()) {
+        publishPendingMapJson(mapName);
+    }
+    for (const QString &path : this->pendingBlockdata.keys()) {
+        publishPendingBlockdata(path);
+    }
+    this->prefetchedMapJson.clear();
+    this->prefetchedBlockdata.clear();
+}
+
+// Returns true if the map isn't loaded yet and loading it now would wait for its tilesets to finish loading.
+bool Project::isMapWaitingForTilesets(const QString &mapName) const {
+    if (this->mapCache.contains(mapName)) {
+        return false;
+    }
+    MapLayout *layout = getPrefetchedMapLayout(mapName);
+    return layout && (isTilesetLoading(layout->tileset_primary_label) || isTilesetLoading(layout->tileset_secondary_label));
+}
+
+// Waits for the tileset to finish loading if it's being loaded in the background, then adds it to the tileset cache.
+void Project::publishPendingTileset(const QString &label) {
+    QFutureWatcher<Tileset*> *watcher = this->pendingTilesets.take(label);
+    if (!watcher) {
+        return;
+    }
+
+    watcher->waitForFinished();
+    Tileset *tileset = watcher->result();
+    watcher->deleteLater();
+    if (tileset) {
+        if (this->tilesetCache.contains(label)) {
+            delete tileset;
+        } else {
+            this->tilesetCache.insert(label, tileset);
+            this->tilesetLastUsed.insert(label, ++this->cacheUseCounter);
+        }
+    }
+    emit tilesetLoaded(label);
+}
+
+void Project::publishPendingTilesets() {
+    for (const QString &label : this->pendingTilesets.keys()) {
+        publishPendingTileset(label);
+    }
+}
+
 void Project::saveTextFile(QString path, QString text) {
+    ParseUtil::invalidateTextFile(path);
     QFile file(path);
     if (file.open(QIODevice::WriteOnly)) {
         file.write(text.toUtf8());
@@ -1579,6 +2193,7 @@ void Project::saveTextFile(QString path, QString text) {
 }
 
 void Project::appendTextFile(QString path, QString text) {
+    ParseUtil::invalidateTextFile(path);
     QFile file(path);
     if (file.open(QIODevice::Append)) {
         file.write(text.toUtf8());
@@ -1611,10 +2226,10 @@ bool Project::readWildMonData() {
     }
 
     QString wildMonJsonFilepath = QString("%1/%2").arg(root).arg(projectConfig.getFilePath(ProjectFilePath::json_wild_encounters));
-    fileWatcher.addPath(wildMonJsonFilepath);
+    watchFile(wildMonJsonFilepath);
 
     OrderedJson::object wildMonObj;
-    if (!parser.tryParseOrderedJsonFile(&wildMonObj, wildMonJsonFilepath)) {
+    if (!threadParser().tryParseOrderedJsonFile(&wildMonObj, wildMonJsonFilepath)) {
         // Failing to read wild encounters data is not a critical error, just disable the
         // encounter editor and log a warning in case the user intended to have this data.
         userConfig.setEncounterJsonActive(false);
@@ -1690,6 +2305,33 @@ bool Project::readWildMonData() {
     return true;
 }
 
+// Reads all of the project's data except its maps and tilesets, which are loaded as they're used.
+// Most of the data is read from independent files, so the readers run concurrently.
+// Readers that depend on data read by another reader are chained after it (see getDataReaderChains).
+bool Project::readDataStructures() {
+    QList<QFuture<bool>> results;
+    for (const auto &chain : getDataReaderChains()) {
+        results.append(QtConcurrent::run([this, chain] {
+            for (const auto &reader : chain) {
+                if (!this->runDataReader(reader))
+                    return false;
+            }
+            return true;
+        }));
+    }
+
+    // The event script labels are given to a QCompleter, so they're read on this thread while the others run.
+    bool success = readEventScriptLabels();
+    for (auto &result : results) {
+        if (!result.result())
+            success = false;
+    }
+    this->cache.save();
+
+    Metatile::setCustomLayout(this);
+    return success;
+}
+
 bool Project::readMapGroups() {
     mapConstantsToMapNames.clear();
     mapNamesToMapConstants.clear();
@@ -1842,7 +2484,7 @@ bool Project::readTilesetLabels() {
         // If the tileset headers file is missing, the user may still have the old assembly format.
         this->usingAsmTilesets = true;
         QString asm_filename = projectConfig.getFilePath(ProjectFilePath::tilesets_headers_asm);
-        QString text = parser.readTextFile(this->root + "/" + asm_filename);
+        QString text = threadParser().readTextFile(this->root + "/" + asm_filename);
         if (text.isEmpty()) {
             logError(QString("Failed to read tileset labels from '%1' or '%2'.").arg(filename).arg(asm_filename));
             return false;
@@ -1859,7 +2501,7 @@ bool Project::readTilesetLabels() {
         filename = asm_filename; // For error reporting further down
     } else {
         this->usingAsmTilesets = false;
-        const auto structs = parser.readCStructs(filename, "", Tileset::getHeaderMemberMap(this->usingAsmTilesets));
+        const auto structs = threadParser().readCStructs(filename, "", Tileset::getHeaderMemberMap(this->usingAsmTilesets));
         QStringList labels = structs.keys();
         // TODO: This is alphabetical, AdvanceMap import wants the vanilla order in tilesetLabelsOrdered
         for (const auto tilesetLabel : labels){
@@ -1883,8 +2525,8 @@ bool Project::readTilesetProperties() {
     QStringList definePrefixes;
     definePrefixes << "\\bNUM_";
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_fieldmap);
-    fileWatcher.addPath(root + "/" + filename);
-    QMap<QString, int> defines = parser.readCDefines(filename, definePrefixes);
+    watchFile(root + "/" + filename);
+    QMap<QString, int> defines = threadParser().readCDefines(filename, definePrefixes);
 
     auto it = defines.find("NUM_TILES_IN_PRIMARY");
     if (it != defines.end()) {
@@ -1941,7 +2583,7 @@ bool Project::readMaxMapDataSize() {
     QStringList definePrefixes;
     definePrefixes << "\\bMAX_";
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_fieldmap); // already in fileWatcher from readTilesetProperties
-    QMap<QString, int> defines = parser.readCDefines(filename, definePrefixes);
+    QMap<QString, int> defines = threadParser().readCDefines(filename, definePrefixes);
 
     auto it = defines.find("MAX_MAP_DATA_SIZE");
     if (it != defines.end()) {
@@ -1970,8 +2612,8 @@ bool Project::readRegionMapSections() {
 
     QStringList prefixes = (QStringList() << "\\bMAPSEC_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_region_map_sections);
-    fileWatcher.addPath(root + "/" + filename);
-    this->mapSectionNameToValue = parser.readCDefines(filename, prefixes);
+    watchFile(root + "/" + filename);
+    this->mapSectionNameToValue = threadParser().readCDefines(filename, prefixes);
     if (this->mapSectionNameToValue.isEmpty()) {
         logError(QString("Failed to read region map sections from %1.").arg(filename));
         return false;
@@ -1988,8 +2630,8 @@ bool Project::readHealLocationConstants() {
     this->healLocationNameToValue.clear();
     QStringList prefixes{ "\\bSPAWN_", "\\bHEAL_LOCATION_" };
     QString constantsFilename = projectConfig.getFilePath(ProjectFilePath::constants_heal_locations);
-    fileWatcher.addPath(root + "/" + constantsFilename);
-    this->healLocationNameToValue = parser.readCDefines(constantsFilename, prefixes);
+    watchFile(root + "/" + constantsFilename);
+    this->healLocationNameToValue = threadParser().readCDefines(constantsFilename, prefixes);
     // No need to check if empty, not finding any heal location constants is ok
     return true;
 }
@@ -2002,8 +2644,8 @@ bool Project::readHealLocations() {
         return false;
 
     QString filename = projectConfig.getFilePath(ProjectFilePath::data_heal_locations);
-    fileWatcher.addPath(root + "/" + filename);
-    QString text = parser.readTextFile(root + "/" + filename);
+    watchFile(root + "/" + filename);
+    QString text = threadParser().readTextFile(root + "/" + filename);
 
     // Strip comments
     static const QRegularExpression re_comments("//.*?(\r\n?|\n)|/\\*.*?\\*/", QRegularExpression::DotMatchesEverythingOption);
@@ -2078,8 +2720,8 @@ bool Project::readHealLocations() {
 bool Project::readItemNames() {
     QStringList prefixes("\\bITEM_(?!(B_)?USE_)");  // Exclude ITEM_USE_ and ITEM_B_USE_ constants
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_items);
-    fileWatcher.addPath(root + "/" + filename);
-    itemNames = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    itemNames = threadParser().readCDefinesSorted(filename, prefixes);
     if (itemNames.isEmpty()) {
         logError(QString("Failed to read item constants from %1").arg(filename));
         return false;
@@ -2091,13 +2733,13 @@ bool Project::readFlagNames() {
     // First read MAX_TRAINERS_COUNT, used to skip over trainer flags
     // If this fails flags may simply be out of order, no need to check for success
     QString opponentsFilename = projectConfig.getFilePath(ProjectFilePath::constants_opponents);
-    fileWatcher.addPath(root + "/" + opponentsFilename);
-    QMap<QString, int> maxTrainers = parser.readCDefines(opponentsFilename, QStringList() << "\\bMAX_");
+    watchFile(root + "/" + opponentsFilename);
+    QMap<QString, int> maxTrainers = threadParser().readCDefines(opponentsFilename, QStringList() << "\\bMAX_");
     // Parse flags
     QStringList prefixes("\\bFLAG_");
     QString flagsFilename = projectConfig.getFilePath(ProjectFilePath::constants_flags);
-    fileWatcher.addPath(root + "/" + flagsFilename);
-    flagNames = parser.readCDefinesSorted(flagsFilename, prefixes, maxTrainers);
+    watchFile(root + "/" + flagsFilename);
+    flagNames = threadParser().readCDefinesSorted(flagsFilename, prefixes, maxTrainers);
     if (flagNames.isEmpty()) {
         logError(QString("Failed to read flag constants from %1").arg(flagsFilename));
         return false;
@@ -2108,8 +2750,8 @@ bool Project::readFlagNames() {
 bool Project::readVarNames() {
     QStringList prefixes("\\bVAR_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_vars);
-    fileWatcher.addPath(root + "/" + filename);
-    varNames = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    varNames = threadParser().readCDefinesSorted(filename, prefixes);
     if (varNames.isEmpty()) {
         logError(QString("Failed to read var constants from %1").arg(filename));
         return false;
@@ -2120,8 +2762,8 @@ bool Project::readVarNames() {
 bool Project::readMovementTypes() {
     QStringList prefixes("\\bMOVEMENT_TYPE_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_obj_event_movement);
-    fileWatcher.addPath(root + "/" + filename);
-    movementTypes = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    movementTypes = threadParser().readCDefinesSorted(filename, prefixes);
     if (movementTypes.isEmpty()) {
         logError(QString("Failed to read movement type constants from %1").arg(filename));
         return false;
@@ -2131,8 +2773,8 @@ bool Project::readMovementTypes() {
 
 bool Project::readInitialFacingDirections() {
     QString filename = projectConfig.getFilePath(ProjectFilePath::initial_facing_table);
-    fileWatcher.addPath(root + "/" + filename);
-    facingDirections = parser.readNamedIndexCArray(filename, "gInitialMovementTypeFacingDirections");
+    watchFile(root + "/" + filename);
+    facingDirections = threadParser().readNamedIndexCArray(filename, "gInitialMovementTypeFacingDirections");
     if (facingDirections.isEmpty()) {
         logError(QString("Failed to read initial movement type facing directions from %1").arg(filename));
         return false;
@@ -2143,8 +2785,8 @@ bool Project::readInitialFacingDirections() {
 bool Project::readMapTypes() {
     QStringList prefixes("\\bMAP_TYPE_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_map_types);
-    fileWatcher.addPath(root + "/" + filename);
-    mapTypes = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    mapTypes = threadParser().readCDefinesSorted(filename, prefixes);
     if (mapTypes.isEmpty()) {
         logError(QString("Failed to read map type constants from %1").arg(filename));
         return false;
@@ -2155,8 +2797,8 @@ bool Project::readMapTypes() {
 bool Project::readMapBattleScenes() {
     QStringList prefixes("\\bMAP_BATTLE_SCENE_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_map_types);
-    fileWatcher.addPath(root + "/" + filename);
-    mapBattleScenes = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    mapBattleScenes = threadParser().readCDefinesSorted(filename, prefixes);
     if (mapBattleScenes.isEmpty()) {
         logError(QString("Failed to read map battle scene constants from %1").arg(filename));
         return false;
@@ -2167,8 +2809,8 @@ bool Project::readMapBattleScenes() {
 bool Project::readWeatherNames() {
     QStringList prefixes("\\bWEATHER_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_weather);
-    fileWatcher.addPath(root + "/" + filename);
-    weatherNames = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    weatherNames = threadParser().readCDefinesSorted(filename, prefixes);
     if (weatherNames.isEmpty()) {
         logError(QString("Failed to read weather constants from %1").arg(filename));
         return false;
@@ -2182,8 +2824,8 @@ bool Project::readCoordEventWeatherNames() {
 
     QStringList prefixes("\\bCOORD_EVENT_WEATHER_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_weather);
-    fileWatcher.addPath(root + "/" + filename);
-    coordEventWeatherNames = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    coordEventWeatherNames = threadParser().readCDefinesSorted(filename, prefixes);
     if (coordEventWeatherNames.isEmpty()) {
         logWarn(QString("Failed to read coord event weather constants from %1. Disabling Weather Trigger events.").arg(filename));
         projectConfig.setEventWeatherTriggerEnabled(false);
@@ -2197,8 +2839,8 @@ bool Project::readSecretBaseIds() {
 
     QStringList prefixes("\\bSECRET_BASE_[A-Za-z0-9_]*_[0-9]+");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_secret_bases);
-    fileWatcher.addPath(root + "/" + filename);
-    secretBaseIds = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    secretBaseIds = threadParser().readCDefinesSorted(filename, prefixes);
     if (secretBaseIds.isEmpty()) {
         logWarn(QString("Failed to read secret base id constants from '%1'. Disabling Secret Base events.").arg(filename));
         projectConfig.setEventSecretBaseEnabled(false);
@@ -2209,8 +2851,8 @@ bool Project::readSecretBaseIds() {
 bool Project::readBgEventFacingDirections() {
     QStringList prefixes("\\bBG_EVENT_PLAYER_FACING_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_event_bg);
-    fileWatcher.addPath(root + "/" + filename);
-    bgEventFacingDirections = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    bgEventFacingDirections = threadParser().readCDefinesSorted(filename, prefixes);
     if (bgEventFacingDirections.isEmpty()) {
         logError(QString("Failed to read bg event facing direction constants from %1").arg(filename));
         return false;
@@ -2221,8 +2863,8 @@ bool Project::readBgEventFacingDirections() {
 bool Project::readTrainerTypes() {
     QStringList prefixes("\\bTRAINER_TYPE_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_trainer_types);
-    fileWatcher.addPath(root + "/" + filename);
-    trainerTypes = parser.readCDefinesSorted(filename, prefixes);
+    watchFile(root + "/" + filename);
+    trainerTypes = threadParser().readCDefinesSorted(filename, prefixes);
     if (trainerTypes.isEmpty()) {
         logError(QString("Failed to read trainer type constants from %1").arg(filename));
         return false;
@@ -2236,8 +2878,8 @@ bool Project::readMetatileBehaviors() {
 
     QStringList prefixes("\\bMB_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_metatile_behaviors);
-    fileWatcher.addPath(root + "/" + filename);
-    this->metatileBehaviorMap = parser.readCDefines(filename, prefixes);
+    watchFile(root + "/" + filename);
+    this->metatileBehaviorMap = threadParser().readCDefines(filename, prefixes);
     if (this->metatileBehaviorMap.isEmpty()) {
         logError(QString("Failed to read metatile behaviors from %1.").arg(filename));
         return false;
@@ -2252,8 +2894,8 @@ bool Project::readMetatileBehaviors() {
 bool Project::readSongNames() {
     QStringList songDefinePrefixes{ "\\bSE_", "\\bMUS_" };
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_songs);
-    fileWatcher.addPath(root + "/" + filename);
-    QMap<QString, int> songDefines = parser.readCDefines(filename, songDefinePrefixes);
+    watchFile(root + "/" + filename);
+    QMap<QString, int> songDefines = threadParser().readCDefines(filename, songDefinePrefixes);
     this->songNames = songDefines.keys();
     this->defaultSong = this->songNames.value(0, "MUS_DUMMY");
     if (this->songNames.isEmpty()) {
@@ -2266,8 +2908,8 @@ bool Project::readSongNames() {
 bool Project::readObjEventGfxConstants() {
     QStringList objEventGfxPrefixes("\\bOBJ_EVENT_GFX_");
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_obj_events);
-    fileWatcher.addPath(root + "/" + filename);
-    this->gfxDefines = parser.readCDefines(filename, objEventGfxPrefixes);
+    watchFile(root + "/" + filename);
+    this->gfxDefines = threadParser().readCDefines(filename, objEventGfxPrefixes);
     if (this->gfxDefines.isEmpty()) {
         logError(QString("Failed to read object event graphics constants from %1.").arg(filename));
         return false;
@@ -2279,16 +2921,16 @@ bool Project::readMiscellaneousConstants() {
     miscConstants.clear();
     if (userConfig.getEncounterJsonActive()) {
         QString filename = projectConfig.getFilePath(ProjectFilePath::constants_pokemon);
-        fileWatcher.addPath(root + "/" + filename);
-        QMap<QString, int> pokemonDefines = parser.readCDefines(filename, { "MIN_", "MAX_" });
+        watchFile(root + "/" + filename);
+        QMap<QString, int> pokemonDefines = threadParser().readCDefines(filename, { "MIN_", "MAX_" });
         miscConstants.insert("max_level_define", pokemonDefines.value("MAX_LEVEL") > pokemonDefines.value("MIN_LEVEL") ? pokemonDefines.value("MAX_LEVEL") : 100);
         miscConstants.insert("min_level_define", pokemonDefines.value("MIN_LEVEL") < pokemonDefines.value("MAX_LEVEL") ? pokemonDefines.value("MIN_LEVEL") : 1);
     }
 
     QString filename = projectConfig.getFilePath(ProjectFilePath::constants_global);
-    fileWatcher.addPath(root + "/" + filename);
+    watchFile(root + "/" + filename);
     QStringList definePrefixes("\\bOBJECT_");
-    QMap<QString, int> defines = parser.readCDefines(filename, definePrefixes);
+    QMap<QString, int> defines = threadParser().readCDefines(filename, definePrefixes);
 
     auto it = defines.find("OBJECT_EVENT_TEMPLATES_COUNT");
     if (it != defines.end()) {
@@ -2403,12 +3045,12 @@ void Project::setEventPixmap(Event *event, bool forceLoad) {
 }
 
 bool Project::readEventGraphics() {
-    fileWatcher.addPaths(QStringList() << root + "/" + projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_pointers)
+    watchFiles(QStringList() << root + "/" + projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_pointers)
                                        << root + "/" + projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_info)
                                        << root + "/" + projectConfig.getFilePath(ProjectFilePath::data_obj_event_pic_tables)
                                        << root + "/" + projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx));
 
-    QMap<QString, QString> pointerHash = parser.readNamedIndexCArray(projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_pointers), "gObjectEventGraphicsInfoPointers");
+    QMap<QString, QString> pointerHash = threadParser().readNamedIndexCArray(projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_pointers), "gObjectEventGraphicsInfoPointers");
 
     qDeleteAll(eventGraphicsMap);
     eventGraphicsMap.clear();
@@ -2424,10 +3066,10 @@ bool Project::readEventGraphics() {
     };
 
     QString filepath = projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx_info);
-    const auto gfxInfos = parser.readCStructs(filepath, "", gfxInfoMemberMap);
+    const auto gfxInfos = threadParser().readCStructs(filepath, "", gfxInfoMemberMap);
 
-    QMap<QString, QStringList> picTables = parser.readCArrayMulti(projectConfig.getFilePath(ProjectFilePath::data_obj_event_pic_tables));
-    QMap<QString, QString> graphicIncbins = parser.readCIncbinMulti(projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx));
+    QMap<QString, QStringList> picTables = threadParser().readCArrayMulti(projectConfig.getFilePath(ProjectFilePath::data_obj_event_pic_tables));
+    QMap<QString, QString> graphicIncbins = threadParser().readCIncbinMulti(projectConfig.getFilePath(ProjectFilePath::data_obj_event_gfx));
 
     for (QString gfxName : gfxNames) {
         EventGraphics * eventGraphics = new EventGraphics;
@@ -2481,10 +3123,10 @@ bool Project::readSpeciesIconPaths() {
     speciesToIconPath.clear();
     QString srcfilename = projectConfig.getFilePath(ProjectFilePath::pokemon_icon_table);
     QString incfilename = projectConfig.getFilePath(ProjectFilePath::data_pokemon_gfx);
-    fileWatcher.addPath(root + "/" + srcfilename);
-    fileWatcher.addPath(root + "/" + incfilename);
-    QMap<QString, QString> monIconNames = parser.readNamedIndexCArray(srcfilename, "gMonIconTable");
-    QMap<QString, QString> iconIncbins = parser.readCIncbinMulti(incfilename);
+    watchFile(root + "/" + srcfilename);
+    watchFile(root + "/" + incfilename);
+    QMap<QString, QString> monIconNames = threadParser().readNamedIndexCArray(srcfilename, "gMonIconTable");
+    QMap<QString, QString> iconIncbins = threadParser().readCIncbinMulti(incfilename);
     for (QString species : monIconNames.keys()) {
         QString path = iconIncbins[monIconNames.value(species)];
         speciesToIconPath.insert(species, root + "/" + path.replace("4bpp", "png"));
@@ -5,6 +5,8 @@
 #include "config.h"
 #include "imageproviders.h"
 
+#include <QTimer>
+
 // TODO: "tilesetNeedsRedraw" is used when redrawing the map after
 // changing a metatile's tiles via script. It is unnecessarily
 // resource intensive. The map metatiles that need to be updated are
@@ -13,8 +15,10 @@
 // set each of the map spaces that use the modified metatile so that
 // the cache could be used, though this would lkely still require a
 // full read of the map.
-void MainWindow::tryRedrawMapArea(bool forceRedraw) {
-    if (!forceRedraw) return;
+void MainWindow::redrawMapArea() {
+    this->mapRedrawPending = false;
+    if (!this->editor || !this->editor->map || !this->editor->map_item)
+        return;
 
     if (this->tilesetNeedsRedraw) {
         // Refresh anything that can display metatiles
@@ -40,6 +44,20 @@ void MainWindow::tryRedrawMapArea(bool forceRedraw) {
     }
 }
 
+// Scripts often make many edits in a row, each of which would otherwise redraw the map.
+// Instead, redraws are deferred until the script returns to Porymap (see Scripting::invokeCallback)
+// or, for scripts run outside of a callback (e.g. by setTimeout), until the next event loop iteration.
+void MainWindow::tryRedrawMapArea(bool forceRedraw) {
+    if (!forceRedraw || this->mapRedrawPending) return;
+    this->mapRedrawPending = true;
+    QTimer::singleShot(0, this, &MainWindow::flushMapRedraw);
+}
+
+void MainWindow::flushMapRedraw() {
+    if (this->mapRedrawPending)
+        this->redrawMapArea();
+}
+
 void MainWindow::tryCommitMapChanges(bool commitChanges) {
     if (commitChanges) {
         Map *map = this->editor->map;
@@ -198,8 +216,68 @@ void MainWindow::shift(int xDelta, int yDelta, bool forceRedraw, bool commitChan
     this->tryRedrawMapArea(forceRedraw);
 }
 
+// Returns the raw values of the blocks in the area as a Uint16Array, row by row.
+// A negative width or height extends the area to the edge of the map.
+// Positions in the area that are outside the map are 0.
+QJSValue MainWindow::getBlockdata(int x, int y, int width, int height) {
+    if (!this->editor || !this->editor->map)
+        return QJSValue();
+    Map *map = this->editor->map;
+    const int mapWidth = map->getWidth();
+    if (width < 0) width = mapWidth - x;
+    if (height < 0) height = map->getHeight() - y;
+    if (width <= 0 || height <= 0)
+        return Scripting::toUint16Array(QVector<uint16_t>());
+    if (!Scripting::isValidBlockdataArea(x, y, width, height)) {
+        logError(QString("Failed to get blockdata: the area %1x%2 is too large").arg(width).arg(height));
+        return QJSValue();
+    }
+
+    QVector<uint16_t> values(width * height, 0);
+    const QRect area = QRect(x, y, width, height) & QRect(0, 0, mapWidth, map->getHeight());
+    const Block *blocks = map->layout->blockdata.constData();
+    for (int j = area.top(); j <= area.bottom(); j++)
+    for (int i = area.left(); i <= area.right(); i++) {
+        const int index = j * mapWidth + i;
+        if (index < map->layout->blockdata.size())
+            values[(j - y) * width + (i - x)] = blocks[index].rawValue();
+    }
+    return Scripting::toUint16Array(values);
+}
+
+// Sets the blocks in the area from an array of raw values, row by row, as one edit.
+// Values for positions outside the map are ignored.
+void MainWindow::setBlockdata(int x, int y, int width, int height, QJSValue rawValues, bool forceRedraw, bool commitChanges) {
+    if (!this->editor || !this->editor->map)
+        return;
+    if (width <= 0 || height <= 0)
+        return;
+    if (!Scripting::isValidBlockdataArea(x, y, width, height)) {
+        logError(QString("Failed to set blockdata: the area %1x%2 is too large").arg(width).arg(height));
+        return;
+    }
+    QVector<uint16_t> values;
+    if (!Scripting::fromUint16Array(rawValues, &values) || values.size() < width * height) {
+        logError(QString("Failed to set blockdata: expected an array of %1 values").arg(width * height));
+        return;
+    }
+
+    Map *map = this->editor->map;
+    const int mapWidth = map->getWidth();
+    const QRect area = QRect(x, y, width, height) & QRect(0, 0, mapWidth, map->getHeight());
+    QVector<BlockUpdate> updates;
+    updates.reserve(area.width() * area.height());
+    for (int j = area.top(); j <= area.bottom(); j++)
+    for (int i = area.left(); i <= area.right(); i++) {
+        updates.append(BlockUpdate{j * mapWidth + i, Block(values.at((j - y) * width + (i - x)))});
+    }
+    map->setBlocks(updates);
+    this->tryCommitMapChanges(commitChanges);
+    this->tryRedrawMapArea(forceRedraw);
+}
+
 void MainWindow::redraw() {
-    this->tryRedrawMapArea(true);
+    this->redrawMapArea();
 }
 
 void MainWindow::commit() {
@@ -545,13 +623,13 @@ int MainWindow::getNumSecondaryTilesetMetatiles() {
 int MainWindow::getNumPrimaryTilesetTiles() {
     if (!this->editor || !this->editor->map || !this->editor->map->layout || !this->editor->map->layout->tileset_primary)
         return 0;
-    return this->editor->map->layout->tileset_primary->tiles.length();
+    return this->editor->map->layout->tileset_primary->numTiles();
 }
 
 int MainWindow::getNumSecondaryTilesetTiles() {
     if (!this->editor || !this->editor->map || !this->editor->map->layout || !this->editor->map->layout->tileset_secondary)
         return 0;
-    return this->editor->map->layout->tileset_secondary->tiles.length();
+    return this->editor->map->layout->tileset_secondary->numTiles();
 }
 
 QString MainWindow::getPrimaryTileset() {
@@ -771,12 +849,11 @@ void MainWindow::setMetatileTile(int metatileId, int tileIndex, QJSValue tileObj
 QJSValue MainWindow::getTilePixels(int tileId) {
     if (tileId < 0 || !this->editor || !this->editor->project || !this->editor->map || !this->editor->map->layout)
         return QJSValue();
-    QImage tileImage = getTileImage(tileId, this->editor->map->layout->tileset_primary, this->editor->map->layout->tileset_secondary);
-    if (tileImage.isNull() || tileImage.sizeInBytes() < 64)
+    const uchar * pixels = Tileset::getTilePixels(tileId, this->editor->map->layout->tileset_primary, this->editor->map->layout->tileset_secondary);
+    if (!pixels)
         return QJSValue();
-    const uchar * pixels = tileImage.constBits();
-    QJSValue pixelArray = Scripting::getEngine()->newArray(64);
-    for (int i = 0; i < 64; i++) {
+    QJSValue pixelArray = Scripting::getEngine()->newArray(Tileset::pixelsPerTile);
+    for (int i = 0; i < Tileset::pixelsPerTile; i++) {
         pixelArray.setProperty(i, pixels[i]);
     }
     return pixelArray;
@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "scripting.h"
+#include "scriptworker.h"
 #include "config.h"
 
 ScriptUtility::ScriptUtility(MainWindow *mainWindow) {
@@ -297,3 +298,82 @@ bool ScriptUtility::isPrimaryTileset(QString tilesetName) {
 bool ScriptUtility::isSecondaryTileset(QString tilesetName) {
     return getSecondaryTilesetNames().contains(tilesetName);
 }
+
+// Runs the function in its own engine on another thread, with a snapshot of the given maps (see ScriptWorker).
+// Returns an id that can be used to cancel it, or -1 if it couldn't be started.
+int ScriptUtility::startWorker(QString filepath, QString functionName, QList<QString> mapNames, QJSValue args, QJSValue onFinished, QJSValue onProgress) {
+    if (!window || !window->editor || !window->editor->project)
+        return -1;
+    Project *project = window->editor->project;
+    if (mapNames.isEmpty() && window->editor->map)
+        mapNames.append(window->editor->map->name);
+
+    QFileInfo fileInfo(filepath);
+    if (fileInfo.isRelative() && !fileInfo.exists())
+        filepath = QDir::cleanPath(userConfig.getProjectDir() + QDir::separator() + filepath);
+
+    ScriptWorker *worker = new ScriptWorker(filepath, functionName, args.toVariant(), project->root);
+    for (const QString &mapName : mapNames) {
+        Map *map = project->getMap(mapName);
+        if (!map) {
+            logError(QString("Failed to start script worker. Unknown map '%1'").arg(mapName));
+            delete worker;
+            return -1;
+        }
+        worker->addMap(map);
+    }
+
+    const int workerId = this->nextWorkerId++;
+    this->workers.insert(workerId, worker);
+    if (onProgress.isCallable()) {
+        connect(worker, &ScriptWorker::progressChanged, this, [onProgress](double progress, QString message) {
+            Scripting::tryErrorJS(onProgress.call(QJSValueList() << progress << message));
+        }, Qt::QueuedConnection);
+    }
+    connect(worker, &QThread::finished, this, [this, workerId, onFinished]() {
+        this->finishWorker(workerId, onFinished);
+    }, Qt::QueuedConnection);
+    worker->start();
+    return workerId;
+}
+
+void ScriptUtility::cancelWorker(int workerId) {
+    ScriptWorker *worker = this->workers.value(workerId, nullptr);
+    if (worker)
+        worker->cancel();
+}
+
+void ScriptUtility::finishWorker(int workerId, QJSValue onFinished) {
+    ScriptWorker *worker = this->workers.take(workerId);
+    if (!worker)
+        return;
+
+    QStringList changedMapNames;
+    if (!worker->getError().isEmpty()) {
+        logError(worker->getError());
+    } else if (!worker->isCanceled() && window && window->editor) {
+        changedMapNames = worker->applyChanges(window->editor->project, window->editor->map);
+    }
+
+    if (onFinished.isCallable()) {
+        QJSEngine *engine = Scripting::getEngine();
+        QJSValue result = engine->newObject();
+        result.setProperty("canceled", worker->isCanceled());
+        result.setProperty("error", worker->getError());
+        result.setProperty("result", engine->toScriptValue(worker->getResult()));
+        result.setProperty("changedMaps", engine->toScriptValue(changedMapNames));
+        Scripting::tryErrorJS(onFinished.call(QJSValueList() << result));
+    }
+    worker->deleteLater();
+}
+
+// Workers are stopped without calling their callbacks, e.g. when the scripts are reloaded.
+void ScriptUtility::stopWorkers() {
+    for (ScriptWorker *worker : this->workers) {
+        disconnect(worker, nullptr, this, nullptr);
+        worker->cancel();
+        worker->wait();
+        delete worker;
+    }
+    this->workers.clear();
+}
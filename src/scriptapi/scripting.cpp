@@ -3,10 +3,13 @@
 #include "config.h"
 #include "aboutporymap.h"
 
+#include <climits>
+
 QMap<CallbackType, QString> callbackFunctions = {
     {OnProjectOpened, "onProjectOpened"},
     {OnProjectClosed, "onProjectClosed"},
     {OnBlockChanged, "onBlockChanged"},
+    {OnBlocksChanged, "onBlocksChanged"},
     {OnBorderMetatileChanged, "onBorderMetatileChanged"},
     {OnBlockHoverChanged, "onBlockHoverChanged"},
     {OnBlockHoverCleared, "onBlockHoverCleared"},
@@ -26,6 +29,7 @@ void Scripting::init(MainWindow *mainWindow) {
     if (instance) {
         instance->engine->setInterrupted(true);
         instance->scriptUtility->clearActions();
+        instance->scriptUtility->stopWorkers();
         qDeleteAll(instance->imageCache);
         delete instance;
     }
@@ -67,6 +71,16 @@ void Scripting::loadModules(QStringList moduleFiles) {
         logInfo(QString("Successfully loaded custom script file '%1'").arg(filepath));
         this->modules.append(module);
     }
+
+    // A module's exports can't change after it's loaded, so callbacks that no script defines can be skipped entirely.
+    for (auto it = callbackFunctions.constBegin(); it != callbackFunctions.constEnd(); it++) {
+        for (const QJSValue &module : this->modules) {
+            if (module.property(it.value()).isCallable()) {
+                this->registeredCallbacks.insert(it.key());
+                break;
+            }
+        }
+    }
 }
 
 void Scripting::populateGlobalObject(MainWindow *mainWindow) {
@@ -111,6 +125,11 @@ void Scripting::populateGlobalObject(MainWindow *mainWindow) {
 bool Scripting::tryErrorJS(QJSValue js) {
     if (!js.isError()) return false;
 
+    logError(getErrorMessage(js));
+    return true;
+}
+
+QString Scripting::getErrorMessage(QJSValue js) {
     // Get properties of the error
     QFileInfo file(js.property("fileName").toString());
     QString fileName = file.fileName();
@@ -120,14 +139,16 @@ bool Scripting::tryErrorJS(QJSValue js) {
     QString fileErrStr = fileName == "undefined" ? "" : QString(" '%1'").arg(fileName);
     QString lineErrStr = lineNumber == "undefined" ? "" : QString(" at line %1").arg(lineNumber);
 
-    logError(QString("Error in custom script%1%2: '%3'")
+    return QString("Error in custom script%1%2: '%3'")
              .arg(fileErrStr)
              .arg(lineErrStr)
-             .arg(js.toString()));
-    return true;
+             .arg(js.toString());
 }
 
 void Scripting::invokeCallback(CallbackType type, QJSValueList args) {
+    if (!this->registeredCallbacks.contains(type)) return;
+
+    this->callDepth++;
     for (QJSValue module : this->modules) {
         QString functionName = callbackFunctions[type];
         QJSValue callbackFunction = module.property(functionName);
@@ -136,6 +157,9 @@ void Scripting::invokeCallback(CallbackType type, QJSValueList args) {
         QJSValue result = callbackFunction.call(args);
         if (tryErrorJS(result)) continue;
     }
+    // Redraw once for all the map edits made by the scripts, now that they've returned to Porymap.
+    if (--this->callDepth == 0)
+        this->mainWindow->flushMapRedraw();
 }
 
 void Scripting::invokeAction(int actionIndex) {
@@ -144,6 +168,7 @@ void Scripting::invokeAction(int actionIndex) {
     if (functionName.isEmpty()) return;
 
     bool foundFunction = false;
+    instance->callDepth++;
     for (QJSValue module : instance->modules) {
         QJSValue callbackFunction = module.property(functionName);
         if (callbackFunction.isUndefined() || !callbackFunction.isCallable())
@@ -154,6 +179,8 @@ void Scripting::invokeAction(int actionIndex) {
         QJSValue result = callbackFunction.call(QJSValueList());
         if (tryErrorJS(result)) continue;
     }
+    if (--instance->callDepth == 0)
+        instance->mainWindow->flushMapRedraw();
     if (!foundFunction) {
         logError(QString("Unknown custom script function '%1'").arg(functionName));
         QMessageBox messageBox(instance->mainWindow);
@@ -185,14 +212,60 @@ void Scripting::cb_ProjectClosed(QString projectPath) {
 
 void Scripting::cb_MetatileChanged(int x, int y, Block prevBlock, Block newBlock) {
     if (!instance) return;
+    if (!instance->registeredCallbacks.contains(OnBlockChanged)
+     && !instance->registeredCallbacks.contains(OnBlocksChanged))
+        return;
 
-    QJSValueList args {
-        x,
-        y,
-        instance->fromBlock(prevBlock),
-        instance->fromBlock(newBlock),
-    };
-    instance->invokeCallback(OnBlockChanged, args);
+    if (instance->blockChangeBatchDepth > 0) {
+        instance->pendingBlockChanges.append(BlockChange{x, y, prevBlock, newBlock});
+    } else {
+        instance->invokeBlockChangeCallbacks({BlockChange{x, y, prevBlock, newBlock}});
+    }
+}
+
+void Scripting::beginBlockChangeBatch() {
+    if (!instance) return;
+    instance->blockChangeBatchDepth++;
+}
+
+void Scripting::endBlockChangeBatch() {
+    if (!instance || instance->blockChangeBatchDepth <= 0) return;
+    if (--instance->blockChangeBatchDepth > 0) return;
+
+    // The callbacks may change more blocks, which start a new batch.
+    const QList<BlockChange> changes = instance->pendingBlockChanges;
+    instance->pendingBlockChanges.clear();
+    if (!changes.isEmpty())
+        instance->invokeBlockChangeCallbacks(changes);
+}
+
+// onBlockChanged is called for each change, for compatibility with older scripts. onBlocksChanged gets all of them at once.
+void Scripting::invokeBlockChangeCallbacks(const QList<BlockChange> &changes) {
+    if (this->registeredCallbacks.contains(OnBlockChanged)) {
+        for (const BlockChange &change : changes) {
+            QJSValueList args {
+                change.x,
+                change.y,
+                fromBlock(change.prevBlock),
+                fromBlock(change.newBlock),
+            };
+            this->invokeCallback(OnBlockChanged, args);
+        }
+    }
+
+    if (this->registeredCallbacks.contains(OnBlocksChanged)) {
+        QJSValue array = this->engine->newArray(changes.length());
+        for (int i = 0; i < changes.length(); i++) {
+            const BlockChange &change = changes.at(i);
+            QJSValue obj = this->engine->newObject();
+            obj.setProperty("x", change.x);
+            obj.setProperty("y", change.y);
+            obj.setProperty("prevBlock", fromBlock(change.prevBlock));
+            obj.setProperty("newBlock", fromBlock(change.newBlock));
+            array.setProperty(i, obj);
+        }
+        this->invokeCallback(OnBlocksChanged, QJSValueList{array});
+    }
 }
 
 void Scripting::cb_BorderMetatileChanged(int x, int y, uint16_t prevMetatileId, uint16_t newMetatileId) {
@@ -312,6 +385,59 @@ QJSValue Scripting::fromBlock(Block block) {
     return obj;
 }
 
+// The array shares no memory with 'values'; the data is copied once into a new ArrayBuffer.
+QJSValue Scripting::toUint16Array(const QVector<uint16_t> &values) {
+    return toUint16Array(instance->engine, values);
+}
+
+QJSValue Scripting::toUint16Array(QJSEngine *engine, const QVector<uint16_t> &values) {
+    QByteArray bytes(reinterpret_cast<const char *>(values.constData()), values.size() * static_cast<int>(sizeof(uint16_t)));
+    QJSValue buffer = engine->toScriptValue(bytes);
+    return engine->globalObject().property("Uint16Array").callAsConstructor(QJSValueList() << buffer);
+}
+
+// Areas read or written at once with getBlockdata/setBlockdata are limited to this many blocks, which is far more
+// than any map has. The area can extend past the map, so without a limit a script could make Porymap allocate
+// an arbitrarily large array, or overflow the area's size.
+static const qint64 maxBlockdataArea = 1 << 24;
+
+// Returns true if the area isn't empty, isn't too large, and doesn't overflow the range of an int.
+bool Scripting::isValidBlockdataArea(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0)
+        return false;
+    if (static_cast<qint64>(x) + width > INT_MAX || static_cast<qint64>(y) + height > INT_MAX)
+        return false;
+    return static_cast<qint64>(width) * height <= maxBlockdataArea;
+}
+
+// Accepts a Uint16Array (or any 16-bit typed array), which is read directly from its buffer,
+// or any other array-like object, which is read one element at a time.
+bool Scripting::fromUint16Array(QJSValue array, QVector<uint16_t> *out) {
+    if (!array.isObject())
+        return false;
+
+    const int length = array.property("length").toInt();
+    if (length < 0)
+        return false;
+    out->resize(length);
+
+    QJSValue buffer = array.property("buffer");
+    if (array.property("BYTES_PER_ELEMENT").toInt() == static_cast<int>(sizeof(uint16_t)) && buffer.isObject()) {
+        const QByteArray bytes = buffer.toVariant().toByteArray();
+        const int offset = array.property("byteOffset").toInt();
+        const qint64 numBytes = static_cast<qint64>(length) * sizeof(uint16_t);
+        if (offset >= 0 && offset + numBytes <= bytes.size()) {
+            memcpy(out->data(), bytes.constData() + offset, numBytes);
+            return true;
+        }
+    }
+
+    for (int i = 0; i < length; i++) {
+        (*out)[i] = static_cast<uint16_t>(array.property(i).toUInt());
+    }
+    return true;
+}
+
 QJSValue Scripting::dimensions(int width, int height) {
     QJSValue obj = instance->engine->newObject();
     obj.setProperty("width", width);
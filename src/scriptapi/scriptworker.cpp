@@ -0,0 +1,270 @@
+#include "scriptworker.h"
+#include "scripting.h"
+#include "editcommands.h"
+#include "project.h"
+#include "tileset.h"
+#include "map.h"
+#include "log.h"
+
+#include <QJSEngine>
+
+// Progress updates are sent to the main thread at most this often, so scripts can report progress freely.
+static const int progressIntervalMs = 50;
+
+ScriptWorker::ScriptWorker(const QString &filepath, const QString &functionName, const QVariant &args, const QString &projectRoot) {
+    this->filepath = filepath;
+    this->functionName = functionName;
+    this->args = args;
+    this->projectRoot = projectRoot;
+}
+
+void ScriptWorker::addMap(Map *map) {
+    if (!map || !map->layout || this->maps.contains(map->name))
+        return;
+
+    MapSnapshot snapshot;
+    snapshot.width = map->getWidth();
+    snapshot.height = map->getHeight();
+    const Blockdata &blockdata = map->layout->blockdata;
+    snapshot.originalBlocks.resize(blockdata.size());
+    for (int i = 0; i < blockdata.size(); i++) {
+        snapshot.originalBlocks[i] = blockdata.at(i).rawValue();
+    }
+    snapshot.blocks = snapshot.originalBlocks;
+
+    // Maps that share tilesets share their metatile attributes.
+    Tileset *primaryTileset = map->layout->tileset_primary;
+    Tileset *secondaryTileset = map->layout->tileset_secondary;
+    const QString tilesetsKey = map->layout->tileset_primary_label + "/" + map->layout->tileset_secondary_label;
+    auto it = this->tilesetAttributes.find(tilesetsKey);
+    if (it == this->tilesetAttributes.end()) {
+        const int numMetatiles = Project::getNumMetatilesTotal();
+        QVector<int> attributes(numMetatiles, -1);
+        QVector<int> behaviors(numMetatiles, -1);
+        for (int metatileId = 0; metatileId < numMetatiles; metatileId++) {
+            Metatile *metatile = Tileset::getMetatile(metatileId, primaryTileset, secondaryTileset);
+            if (metatile) {
+                attributes[metatileId] = metatile->getAttributes();
+                behaviors[metatileId] = metatile->behavior;
+            }
+        }
+        it = this->tilesetAttributes.insert(tilesetsKey, qMakePair(attributes, behaviors));
+    }
+    snapshot.metatileAttributes = it->first;
+    snapshot.metatileBehaviors = it->second;
+
+    this->maps.insert(map->name, snapshot);
+    this->mapNames.append(map->name);
+}
+
+void ScriptWorker::cancel() {
+    this->canceled.storeRelaxed(1);
+    QMutexLocker locker(&this->engineMutex);
+    if (this->engine)
+        this->engine->setInterrupted(true);
+}
+
+QStringList ScriptWorker::getChangedMapNames() const {
+    QStringList changedMapNames;
+    for (const QString &mapName : this->mapNames) {
+        if (this->changedMapNames.contains(mapName))
+            changedMapNames.append(mapName);
+    }
+    return changedMapNames;
+}
+
+void ScriptWorker::reportProgress(double progress, const QString &message) {
+    if (this->progressTimer.isValid() && this->progressTimer.elapsed() < progressIntervalMs && progress < 1.0)
+        return;
+    this->progressTimer.start();
+    emit progressChanged(qBound(0.0, progress, 1.0), message);
+}
+
+void ScriptWorker::run() {
+    QJSEngine engine;
+    engine.installExtensions(QJSEngine::ConsoleExtension);
+    {
+        QMutexLocker locker(&this->engineMutex);
+        if (this->isCanceled())
+            return;
+        this->engine = &engine;
+    }
+
+    ScriptWorkerApi api(this, &engine);
+    QJSEngine::setObjectOwnership(&api, QJSEngine::CppOwnership);
+    engine.globalObject().setProperty("worker", engine.newQObject(&api));
+
+    QJSValue module = engine.importModule(this->filepath);
+    if (module.isError()) {
+        this->error = Scripting::getErrorMessage(module);
+    } else {
+        QJSValue function = module.property(this->functionName);
+        if (!function.isCallable()) {
+            this->error = QString("Unknown custom script function '%1' in '%2'").arg(this->functionName).arg(this->filepath);
+        } else {
+            QJSValue value = function.call(QJSValueList() << engine.toScriptValue(this->args));
+            if (value.isError()) {
+                if (!this->isCanceled())
+                    this->error = Scripting::getErrorMessage(value);
+            } else {
+                this->result = value.toVariant();
+            }
+        }
+    }
+
+    QMutexLocker locker(&this->engineMutex);
+    this->engine = nullptr;
+}
+
+QStringList ScriptWorker::applyChanges(Project *project, Map *currentMap) {
+    QStringList appliedMapNames;
+    if (!project || project->root != this->projectRoot)
+        return appliedMapNames;
+
+    for (const QString &mapName : this->getChangedMapNames()) {
+        const MapSnapshot &snapshot = this->maps[mapName];
+        Map *map = project->getMap(mapName);
+        if (!map || !map->layout)
+            continue;
+        if (map->getWidth() != snapshot.width || map->getHeight() != snapshot.height
+         || map->layout->blockdata.size() != snapshot.blocks.size()) {
+            logWarn(QString("Discarding script edits to map '%1', which was resized while the script was running.").arg(mapName));
+            continue;
+        }
+
+        Blockdata newBlockdata = map->layout->blockdata;
+        bool changed = false;
+        for (int i = 0; i < snapshot.blocks.size(); i++) {
+            const uint16_t rawValue = snapshot.blocks.at(i);
+            if (rawValue != snapshot.originalBlocks.at(i) && rawValue != newBlockdata.at(i).rawValue()) {
+                newBlockdata[i] = Block(rawValue);
+                changed = true;
+            }
+        }
+        if (!changed)
+            continue;
+
+        // Only the open map has pixmap items. Items set on any other map were deleted when it was closed.
+        if (map != currentMap) {
+            map->setMapItem(nullptr);
+            map->setCollisionItem(nullptr);
+            map->setBorderItem(nullptr);
+        }
+
+        const QSize mapDimensions(map->getWidth(), map->getHeight());
+        const QSize borderDimensions(map->getBorderWidth(), map->getBorderHeight());
+        map->editHistory.push(new ScriptEditMap(map,
+            mapDimensions, mapDimensions,
+            map->layout->blockdata, newBlockdata,
+            borderDimensions, borderDimensions,
+            map->layout->border, map->layout->border
+        ));
+        appliedMapNames.append(mapName);
+    }
+    return appliedMapNames;
+}
+
+ScriptWorkerApi::ScriptWorkerApi(ScriptWorker *worker, QJSEngine *engine) {
+    this->worker = worker;
+    this->engine = engine;
+}
+
+ScriptWorker::MapSnapshot *ScriptWorkerApi::getMap(const QString &mapName) {
+    auto it = this->worker->maps.find(mapName);
+    if (it == this->worker->maps.end()) {
+        this->engine->throwError(QString("Map '%1' was not given to the worker").arg(mapName));
+        return nullptr;
+    }
+    return &it.value();
+}
+
+QList<QString> ScriptWorkerApi::getMapNames() {
+    return this->worker->mapNames;
+}
+
+QJSValue ScriptWorkerApi::getDimensions(QString mapName) {
+    ScriptWorker::MapSnapshot *map = this->getMap(mapName);
+    if (!map)
+        return QJSValue();
+    QJSValue obj = this->engine->newObject();
+    obj.setProperty("width", map->width);
+    obj.setProperty("height", map->height);
+    return obj;
+}
+
+// Same as map.getBlockdata, for a map given to the worker.
+QJSValue ScriptWorkerApi::getBlockdata(QString mapName, int x, int y, int width, int height) {
+    ScriptWorker::MapSnapshot *map = this->getMap(mapName);
+    if (!map)
+        return QJSValue();
+    if (width < 0) width = map->width - x;
+    if (height < 0) height = map->height - y;
+    if (width <= 0 || height <= 0)
+        return Scripting::toUint16Array(this->engine, QVector<uint16_t>());
+    if (!Scripting::isValidBlockdataArea(x, y, width, height)) {
+        this->engine->throwError(QString("Failed to get blockdata: the area %1x%2 is too large").arg(width).arg(height));
+        return QJSValue();
+    }
+
+    if (x == 0 && y == 0 && width == map->width && height == map->height)
+        return Scripting::toUint16Array(this->engine, map->blocks);
+
+    QVector<uint16_t> values(width * height, 0);
+    const QRect area = QRect(x, y, width, height) & QRect(0, 0, map->width, map->height);
+    for (int j = area.top(); j <= area.bottom(); j++)
+    for (int i = area.left(); i <= area.right(); i++) {
+        values[(j - y) * width + (i - x)] = map->blocks.value(j * map->width + i);
+    }
+    return Scripting::toUint16Array(this->engine, values);
+}
+
+// Same as map.setBlockdata, for a map given to the worker. The changes are applied once the worker finishes.
+void ScriptWorkerApi::setBlockdata(QString mapName, int x, int y, int width, int height, QJSValue rawValues) {
+    ScriptWorker::MapSnapshot *map = this->getMap(mapName);
+    if (!map || width <= 0 || height <= 0)
+        return;
+    if (!Scripting::isValidBlockdataArea(x, y, width, height)) {
+        this->engine->throwError(QString("Failed to set blockdata: the area %1x%2 is too large").arg(width).arg(height));
+        return;
+    }
+    QVector<uint16_t> values;
+    if (!Scripting::fromUint16Array(rawValues, &values) || values.size() < width * height) {
+        this->engine->throwError(QString("Failed to set blockdata: expected an array of %1 values").arg(width * height));
+        return;
+    }
+
+    const QRect area = QRect(x, y, width, height) & QRect(0, 0, map->width, map->height);
+    for (int j = area.top(); j <= area.bottom(); j++)
+    for (int i = area.left(); i <= area.right(); i++) {
+        const int index = j * map->width + i;
+        if (index < map->blocks.size())
+            map->blocks[index] = values.at((j - y) * width + (i - x));
+    }
+    this->worker->changedMapNames.insert(mapName);
+}
+
+int ScriptWorkerApi::getMetatileAttributes(QString mapName, int metatileId) {
+    ScriptWorker::MapSnapshot *map = this->getMap(mapName);
+    if (!map)
+        return -1;
+    return map->metatileAttributes.value(metatileId, -1);
+}
+
+int ScriptWorkerApi::getMetatileBehavior(QString mapName, int metatileId) {
+    ScriptWorker::MapSnapshot *map = this->getMap(mapName);
+    if (!map)
+        return -1;
+    return map->metatileBehaviors.value(metatileId, -1);
+}
+
+void ScriptWorkerApi::setProgress(double progress, QString message) {
+    this->worker->reportProgress(progress, message);
+}
+
+bool ScriptWorkerApi::isCanceled() {
+    return this->worker->isCanceled();
+}
+
+void ScriptWorkerApi::log(QString message) {
+    logInfo(message);
+}
@@ -2,7 +2,6 @@
 #include "imageproviders.h"
 #include "metatile.h"
 #include "editcommands.h"
-#include <QPainter>
 
 void BorderMetatilesPixmapItem::mousePressEvent(QGraphicsSceneMouseEvent *event) {
     MetatileSelection selection = this->metatileSelector->getMetatileSelection();
@@ -32,7 +31,6 @@ void BorderMetatilesPixmapItem::draw() {
     int width = map->getBorderWidth();
     int height = map->getBorderHeight();
     QImage image(16 * width, 16 * height, QImage::Format_RGBA8888);
-    QPainter painter(&image);
 
     for (int i = 0; i < width; i++) {
         for (int j = 0; j < height; j++) {
@@ -45,11 +43,10 @@ void BorderMetatilesPixmapItem::draw() {
                         map->metatileLayerOrder,
                         map->metatileLayerOpacity);
             QPoint metatile_origin = QPoint(x, y);
-            painter.drawImage(metatile_origin, metatile_image);
+            drawMetatileImage(&image, metatile_origin, metatile_image);
         }
     }
 
-    painter.end();
     this->setPixmap(QPixmap::fromImage(image));
 
     emit borderMetatilesChanged();
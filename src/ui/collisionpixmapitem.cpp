@@ -48,10 +48,14 @@ void CollisionPixmapItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
     emit mouseEvent(event, this);
 }
 
+void CollisionPixmapItem::renderChunk(QImage *image, const QRect &area) {
+    map->renderCollisionMetatiles(image, area);
+}
+
 void CollisionPixmapItem::draw(bool ignoreCache) {
     if (map) {
         map->setCollisionItem(this);
-        setPixmap(map->renderCollision(ignoreCache));
+        updateChunks(map->takeDirtyCollisionItemArea(), ignoreCache);
         setOpacity(*this->opacity);
     }
 }
@@ -107,14 +111,14 @@ void CollisionPixmapItem::magicFill(QGraphicsSceneMouseEvent *event) {
     if (event->type() == QEvent::GraphicsSceneMouseRelease) {
         this->actionId_++;
     } else if (map) {
-        Blockdata oldCollision = map->layout->blockdata;
         QPoint pos = Metatile::coordFromPixmapCoord(event->pos());
         uint16_t collision = this->movementPermissionsSelector->getSelectedCollision();
         uint16_t elevation = this->movementPermissionsSelector->getSelectedElevation();
-        map->magicFillCollisionElevation(pos.x(), pos.y(), collision, elevation);
+        BlockdataDelta delta;
+        map->magicFillCollisionElevation(pos.x(), pos.y(), collision, elevation, &delta);
 
-        if (map->layout->blockdata != oldCollision) {
-            map->editHistory.push(new MagicFillCollision(map, oldCollision, map->layout->blockdata));
+        if (!delta.isEmpty()) {
+            map->editHistory.push(new MagicFillCollision(map, delta));
         }
     }
 }
@@ -1,6 +1,7 @@
 #include "config.h"
 #include "imageproviders.h"
 #include "log.h"
+#include "tilerenderer.h"
 #include <QPainter>
 
 QImage getCollisionMetatileImage(Block block) {
@@ -28,7 +29,19 @@ QImage getMetatileImage(
         metatile_image.fill(Qt::magenta);
         return metatile_image;
     }
-    return getMetatileImage(metatile, primaryTileset, secondaryTileset, layerOrder, layerOpacity, useTruePalettes);
+    if (!primaryTileset || !secondaryTileset) {
+        return getMetatileImage(metatile, primaryTileset, secondaryTileset, layerOrder, layerOpacity, useTruePalettes);
+    }
+
+    // Most maps only use a small number of distinct metatiles, so reuse their composited images.
+    MetatileImageCache *cache = &secondaryTileset->metatileImageCache;
+    cache->validate(primaryTileset, secondaryTileset, layerOrder, layerOpacity);
+    QImage metatile_image = cache->find(metatileId, metatile, useTruePalettes);
+    if (metatile_image.isNull()) {
+        metatile_image = getMetatileImage(metatile, primaryTileset, secondaryTileset, layerOrder, layerOpacity, useTruePalettes);
+        cache->insert(metatileId, metatile, useTruePalettes, metatile_image);
+    }
+    return metatile_image;
 }
 
 QImage getMetatileImage(
@@ -48,7 +61,6 @@ QImage getMetatileImage(
 
     QList<QList<QRgb>> palettes = Tileset::getBlockPalettes(primaryTileset, secondaryTileset, useTruePalettes);
 
-    QPainter metatile_painter(&metatile_image);
     bool isTripleLayerMetatile = projectConfig.getTripleLayerMetatilesEnabled();
     const int numLayers = 3; // When rendering, metatiles always have 3 layers
     int layerType = metatile->layerType;
@@ -90,49 +102,43 @@ QImage getMetatileImage(
             }
         }
 
-        QImage tile_image = getTileImage(tile.tileId, primaryTileset, secondaryTileset);
-        if (tile_image.isNull()) {
+        const uchar *tilePixels = Tileset::getTilePixels(tile.tileId, primaryTileset, secondaryTileset);
+        if (!tilePixels) {
             // Some metatiles specify tiles that are outside the valid range.
             // These are treated as completely transparent, so they can be skipped without
             // being drawn unless they're on the bottom layer, in which case we need
             // a placeholder because garbage will be drawn otherwise.
             if (l == bottomLayer) {
-                metatile_painter.fillRect(x * 8, y * 8, 8, 8, palettes.value(0).value(0));
+                TileRenderer::fillTile(metatile_image.scanLine(y * 8) + x * 8 * 4, metatile_image.bytesPerLine(),
+                                       TileRenderer::toRgba8888(palettes.value(0).value(0)));
             }
             continue;
         }
 
         // Colorize the metatile tiles with its palette.
+        // Colors missing from the palette keep the color from the tiles image.
+        uint32_t colors[16];
+        Tileset *tileset = Tileset::getTileTileset(tile.tileId, primaryTileset, secondaryTileset);
+        const QVector<QRgb> imageColors = tileset->tilesImage.colorTable();
+        for (int j = 0; j < 16; j++) {
+            colors[j] = TileRenderer::toRgba8888(imageColors.value(j, qRgb(0, 0, 0)));
+        }
         if (tile.palette < palettes.length()) {
-            QList<QRgb> palette = palettes.value(tile.palette);
-            for (int j = 0; j < palette.length(); j++) {
-                tile_image.setColor(j, palette.value(j));
+            const QList<QRgb> &palette = palettes.at(tile.palette);
+            for (int j = 0; j < palette.length() && j < 16; j++) {
+                colors[j] = TileRenderer::toRgba8888(palette.at(j));
             }
         } else {
             logWarn(QString("Tile '%1' is referring to invalid palette number: '%2'").arg(tile.tileId).arg(tile.palette));
         }
 
-        QPoint origin = QPoint(x*8, y*8);
         float opacity = layerOpacity.size() >= numLayers ? layerOpacity[l] : 1.0;
-        if (opacity < 1.0) {
-            int alpha = 255 * opacity;
-            for (int c = 0; c < tile_image.colorCount(); c++) {
-                QColor color(tile_image.color(c));
-                color.setAlpha(alpha);
-                tile_image.setColor(c, color.rgba());
-            }
-        }
 
         // The top layer of the metatile has its first color displayed at transparent.
-        if (l != bottomLayer) {
-            QColor color(tile_image.color(0));
-            color.setAlpha(0);
-            tile_image.setColor(0, color.rgba());
-        }
-
-        metatile_painter.drawImage(origin, tile_image.mirrored(tile.xflip, tile.yflip));
+        TileRenderer::drawTile(metatile_image.scanLine(y * 8) + x * 8 * 4, metatile_image.bytesPerLine(),
+                               tilePixels, colors, tile.xflip, tile.yflip, l != bottomLayer,
+                               opacity < 1.0 ? static_cast<int>(255 * opacity) : 255);
     }
-    metatile_painter.end();
 
     return metatile_image;
 }
@@ -143,7 +149,16 @@ QImage getTileImage(uint16_t tileId, Tileset *primaryTileset, Tileset *secondary
     if (!tileset) {
         return QImage();
     }
-    return tileset->tiles.value(index, QImage());
+    const uchar *pixels = tileset->getTilePixels(index);
+    if (!pixels) {
+        return QImage();
+    }
+    QImage tileImage(Tileset::tileWidth, Tileset::tileHeight, QImage::Format_Indexed8);
+    tileImage.setColorTable(tileset->tilesImage.colorTable());
+    for (int y = 0; y < Tileset::tileHeight; y++) {
+        memcpy(tileImage.scanLine(y), pixels + y * Tileset::tileWidth, Tileset::tileWidth);
+    }
+    return tileImage;
 }
 
 QImage getColoredTileImage(uint16_t tileId, Tileset *primaryTileset, Tileset *secondaryTileset, QList<QRgb> palette) {
@@ -178,3 +193,21 @@ void flattenTo4bppImage(QImage * image) {
     for (int i = 0; i < image->sizeInBytes(); i++, pixel++)
         *pixel %= 16;
 }
+
+// Copies a rendered metatile image into an RGBA8888 image, e.g. a map image.
+// Metatile images are opaque, so this is equivalent to drawing it with a QPainter, but much cheaper.
+void drawMetatileImage(QImage *dest, const QPoint &origin, const QImage &metatileImage) {
+    if (!dest || dest->format() != QImage::Format_RGBA8888) {
+        return;
+    }
+    const QImage src = metatileImage.format() == QImage::Format_RGBA8888
+                     ? metatileImage
+                     : metatileImage.convertToFormat(QImage::Format_RGBA8888);
+    QRect area = QRect(origin, src.size()).intersected(dest->rect());
+    if (area.isEmpty()) {
+        return;
+    }
+    TileRenderer::blit(dest->scanLine(area.y()) + area.x() * 4, dest->bytesPerLine(),
+                       src.constScanLine(area.y() - origin.y()) + (area.x() - origin.x()) * 4, src.bytesPerLine(),
+                       area.width(), area.height());
+}
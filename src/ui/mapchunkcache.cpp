@@ -0,0 +1,99 @@
+#include "mapchunkcache.h"
+#include <QPainter>
+
+MapChunkCache::MapChunkCache(RenderFunc renderFunc, qint64 maxBytes) {
+    this->renderFunc = renderFunc;
+    this->maxBytes = maxBytes;
+}
+
+void MapChunkCache::setMapSize(const QSize &size) {
+    if (size == this->mapSize)
+        return;
+    this->clear();
+    this->mapSize = size;
+}
+
+QRect MapChunkCache::getChunkArea(int chunkX, int chunkY) const {
+    QRect area(chunkX * chunkSize, chunkY * chunkSize, chunkSize, chunkSize);
+    return area & QRect(QPoint(0, 0), this->mapSize);
+}
+
+void MapChunkCache::invalidate(const QRect &area) {
+    QRect mapArea = area & QRect(QPoint(0, 0), this->mapSize);
+    if (mapArea.isEmpty())
+        return;
+
+    for (int chunkY = mapArea.top() / chunkSize; chunkY <= mapArea.bottom() / chunkSize; chunkY++)
+    for (int chunkX = mapArea.left() / chunkSize; chunkX <= mapArea.right() / chunkSize; chunkX++) {
+        auto it = this->chunks.find(getKey(chunkX, chunkY));
+        if (it != this->chunks.end()) {
+            it->dirtyArea |= mapArea & getChunkArea(chunkX, chunkY);
+        }
+    }
+}
+
+void MapChunkCache::invalidateAll() {
+    this->invalidate(QRect(QPoint(0, 0), this->mapSize));
+}
+
+void MapChunkCache::clear() {
+    this->chunks.clear();
+    this->totalBytes = 0;
+}
+
+void MapChunkCache::updateChunk(Chunk *chunk, const QRect &chunkArea) {
+    if (chunk->pixmap.isNull()) {
+        chunk->pixmap = QPixmap(chunkArea.width() * 16, chunkArea.height() * 16);
+        chunk->pixmap.fill(Qt::transparent);
+        chunk->dirtyArea = chunkArea;
+        this->totalBytes += static_cast<qint64>(chunk->pixmap.width()) * chunk->pixmap.height() * 4;
+    }
+    if (chunk->dirtyArea.isEmpty())
+        return;
+
+    // Only the changed area is rendered and copied into the chunk's pixmap.
+    QRect area = chunk->dirtyArea;
+    QImage image(area.width() * 16, area.height() * 16, QImage::Format_RGBA8888);
+    image.fill(Qt::transparent);
+    this->renderFunc(&image, area);
+
+    QPainter painter(&chunk->pixmap);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage((area.topLeft() - chunkArea.topLeft()) * 16, image);
+    painter.end();
+    chunk->dirtyArea = QRect();
+}
+
+void MapChunkCache::paint(QPainter *painter, const QRectF &exposedRect) {
+    QRect pixelRect = exposedRect.toAlignedRect() & QRect(QPoint(0, 0), this->mapSize * 16);
+    if (pixelRect.isEmpty())
+        return;
+
+    const quint64 paintStart = ++this->useCounter;
+    const int chunkPixels = chunkSize * 16;
+    for (int chunkY = pixelRect.top() / chunkPixels; chunkY <= pixelRect.bottom() / chunkPixels; chunkY++)
+    for (int chunkX = pixelRect.left() / chunkPixels; chunkX <= pixelRect.right() / chunkPixels; chunkX++) {
+        QRect chunkArea = getChunkArea(chunkX, chunkY);
+        Chunk *chunk = &this->chunks[getKey(chunkX, chunkY)];
+        this->updateChunk(chunk, chunkArea);
+        chunk->lastUsed = paintStart;
+        painter->drawPixmap(chunkArea.topLeft() * 16, chunk->pixmap);
+    }
+    this->evict(paintStart);
+}
+
+// Discards the least recently painted chunks until the cache is within its memory limit.
+// Chunks painted since keepUsedSince are currently visible, so they're kept regardless.
+void MapChunkCache::evict(quint64 keepUsedSince) {
+    while (this->totalBytes > this->maxBytes) {
+        auto oldest = this->chunks.end();
+        for (auto it = this->chunks.begin(); it != this->chunks.end(); it++) {
+            if (it->lastUsed < keepUsedSince && (oldest == this->chunks.end() || it->lastUsed < oldest->lastUsed))
+                oldest = it;
+        }
+        if (oldest == this->chunks.end())
+            break;
+        this->totalBytes -= static_cast<qint64>(oldest->pixmap.width()) * oldest->pixmap.height() * 4;
+        this->chunks.erase(oldest);
+    }
+}
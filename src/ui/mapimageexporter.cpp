@@ -87,6 +87,8 @@ void MapImageExporter::saveImage() {
                 }
                 pixmap.save(filepath);
                 progress.close();
+                // The stitch can load every connected map in the region.
+                editor->project->trimCachesKeeping({editor->map, this->map});
                 break;
             }
             case ImageExporterMode::Timelapse:
@@ -177,6 +179,11 @@ void MapImageExporter::saveImage() {
 }
 
 bool MapImageExporter::historyItemAppliesToFrame(const QUndoCommand *command) {
+    // Commands that were compacted to save memory don't change anything anymore, so they don't get a frame.
+    const MapBlocksCommand *blocksCommand = dynamic_cast<const MapBlocksCommand *>(command);
+    if (blocksCommand && blocksCommand->isReleased())
+        return false;
+
     switch (command->id() & 0xFF) {
         case CommandId::ID_PaintMetatile:
         case CommandId::ID_BucketFillMetatile:
@@ -209,77 +216,23 @@ bool MapImageExporter::historyItemAppliesToFrame(const QUndoCommand *command) {
     }
 }
 
-struct StitchedMap {
-    int x;
-    int y;
-    Map* map;
-};
-
 QPixmap MapImageExporter::getStitchedImage(QProgressDialog *progress, bool includeBorder) {
-    // Do a breadth-first search to gather a collection of
-    // all reachable maps with their relative offsets.
-    QSet<QString> visited;
-    QList<StitchedMap> stitchedMaps;
-    QList<StitchedMap> unvisited;
-    unvisited.append(StitchedMap{0, 0, this->editor->map});
-
     progress->setLabelText("Gathering stitched maps...");
-    while (!unvisited.isEmpty()) {
-        if (progress->wasCanceled()) {
-            return QPixmap();
-        }
-        progress->setMaximum(visited.size() + unvisited.size());
-        progress->setValue(visited.size());
-
-        StitchedMap cur = unvisited.takeFirst();
-        if (visited.contains(cur.map->name))
-            continue;
-        visited.insert(cur.map->name);
-        stitchedMaps.append(cur);
-
-        for (MapConnection *connection : cur.map->connections) {
-            if (connection->direction == "dive" || connection->direction == "emerge")
-                continue;
-            int x = cur.x;
-            int y = cur.y;
-            int offset = connection->offset;
-            Map *connectionMap = this->editor->project->loadMap(connection->map_name);
-            if (connection->direction == "up") {
-                x += offset;
-                y -= connectionMap->getHeight();
-            } else if (connection->direction == "down") {
-                x += offset;
-                y += cur.map->getHeight();
-            } else if (connection->direction == "left") {
-                x -= connectionMap->getWidth();
-                y += offset;
-            } else if (connection->direction == "right") {
-                x += cur.map->getWidth();
-                y += offset;
-            }
-            unvisited.append(StitchedMap{x, y, connectionMap});
-        }
+    QList<StitchedMap> stitchedMaps = this->editor->project->getStitchedMaps(this->editor->map, [progress](int numVisited, int numFound) {
+        progress->setMaximum(numFound);
+        progress->setValue(numVisited);
+        return !progress->wasCanceled();
+    });
+    if (progress->wasCanceled()) {
+        return QPixmap();
     }
 
     // Determine the overall dimensions of the stitched maps.
-    int maxX = INT_MIN;
-    int minX = INT_MAX;
-    int maxY = INT_MIN;
-    int minY = INT_MAX;
-    for (StitchedMap map : stitchedMaps) {
-        int left = map.x;
-        int right = map.x + map.map->getWidth();
-        int top = map.y;
-        int bottom = map.y + map.map->getHeight();
-        if (left < minX)
-            minX = left;
-        if (right > maxX)
-            maxX = right;
-        if (top < minY)
-            minY = top;
-        if (bottom > maxY)
-            maxY = bottom;
-    }
+    const QRect bounds = Project::getStitchedBounds(stitchedMaps);
+    int minX = bounds.left();
+    int maxX = bounds.left() + bounds.width();
+    int minY = bounds.top();
+    int maxY = bounds.top() + bounds.height();
 
     if (includeBorder) {
         minX -= STITCH_MODE_BORDER_DISTANCE;
@@ -408,6 +361,8 @@ QPixmap MapImageExporter::getFormattedMapPixmap(Map *map, bool ignoreBorder) {
     }
 
     // draw events
+    if (showObjects || showWarps || showBGs || showTriggers || showHealSpots)
+        editor->project->loadMapEvents(map);
     QPainter eventPainter(&pixmap);
     QList<Event *> events = map->getAllEvents();
     int pixelOffset = 0;
@@ -5,6 +5,8 @@
 
 #include "editcommands.h"
 
+#include <QStyleOptionGraphicsItem>
+
 #define SWAP(a, b) do { if (a != b) { a ^= b; b ^= a; a ^= b; } } while (0)
 
 void MapPixmapItem::paint(QGraphicsSceneMouseEvent *event) {
@@ -458,35 +460,39 @@ void MapPixmapItem::magicFill(
             return;
         }
 
-        Blockdata oldMetatiles = !fromScriptCall ? map->layout->blockdata : Blockdata();
-
         bool setCollisions = selectedCollisions.length() == selectedMetatiles.length();
-        uint16_t metatileId = block.metatileId;
-        for (int y = 0; y < map->getHeight(); y++) {
-            for (int x = 0; x < map->getWidth(); x++) {
-                if (map->getBlock(x, y, &block) && block.metatileId == metatileId) {
-                    int xDiff = x - initialX;
-                    int yDiff = y - initialY;
-                    int i = xDiff % selectionDimensions.x();
-                    int j = yDiff % selectionDimensions.y();
-                    if (i < 0) i = selectionDimensions.x() + i;
-                    if (j < 0) j = selectionDimensions.y() + j;
-                    int index = j * selectionDimensions.x() + i;
-                    if (selectedMetatiles.at(index).enabled) {
-                        block.metatileId = selectedMetatiles.at(index).metatileId;
-                        if (setCollisions) {
-                            CollisionSelectionItem item = selectedCollisions.at(index);
-                            block.collision = item.collision;
-                            block.elevation = item.elevation;
-                        }
-                        map->setBlock(x, y, block, !fromScriptCall);
-                    }
+        const int width = map->getWidth();
+        const int numBlocks = width * map->getHeight();
+        const QVector<int> matches = map->layout->blockdata.findMatching(Block::metatileIdMask, block.metatileId);
+        QVector<BlockUpdate> updates;
+        updates.reserve(matches.size());
+        for (int blockIndex : matches) {
+            if (blockIndex >= numBlocks)
+                break;
+            int xDiff = blockIndex % width - initialX;
+            int yDiff = blockIndex / width - initialY;
+            int i = xDiff % selectionDimensions.x();
+            int j = yDiff % selectionDimensions.y();
+            if (i < 0) i = selectionDimensions.x() + i;
+            if (j < 0) j = selectionDimensions.y() + j;
+            int index = j * selectionDimensions.x() + i;
+            if (selectedMetatiles.at(index).enabled) {
+                block = map->layout->blockdata.at(blockIndex);
+                block.metatileId = selectedMetatiles.at(index).metatileId;
+                if (setCollisions) {
+                    CollisionSelectionItem item = selectedCollisions.at(index);
+                    block.collision = item.collision;
+                    block.elevation = item.elevation;
                 }
+                updates.append(BlockUpdate{blockIndex, block});
             }
         }
+        // The undo command only stores the blocks that setBlocks changed, so the map doesn't need to be copied or compared.
+        BlockdataDelta delta;
+        map->setBlocks(updates, !fromScriptCall, fromScriptCall ? nullptr : &delta);
 
-        if (!fromScriptCall && map->layout->blockdata != oldMetatiles) {
-            map->editHistory.push(new MagicFillMetatile(map, oldMetatiles, map->layout->blockdata, actionId_));
+        if (!delta.isEmpty()) {
+            map->editHistory.push(new MagicFillMetatile(map, delta, actionId_));
         }
     }
 }
@@ -512,54 +518,31 @@ void MapPixmapItem::floodFill(
     bool setCollisions = selectedCollisions.length() == selectedMetatiles.length();
     Blockdata oldMetatiles = !fromScriptCall ? map->layout->blockdata : Blockdata();
 
-    QSet<int> visited;
-    QList<QPoint> todo;
-    todo.append(QPoint(initialX, initialY));
-    while (todo.length()) {
-        QPoint point = todo.takeAt(0);
-        int x = point.x();
-        int y = point.y();
-        Block block;
-        if (!map->getBlock(x, y, &block)) {
-            continue;
-        }
-
-        visited.insert(x + y * map->getWidth());
-        int xDiff = x - initialX;
-        int yDiff = y - initialY;
+    const int width = map->getWidth();
+    const QVector<int> area = map->getFloodFillArea(initialX, initialY, Block::metatileIdMask);
+    QVector<BlockUpdate> updates;
+    updates.reserve(area.size());
+    for (int blockIndex : area) {
+        Block block = map->layout->blockdata.at(blockIndex);
+        int xDiff = blockIndex % width - initialX;
+        int yDiff = blockIndex / width - initialY;
         int i = xDiff % selectionDimensions.x();
         int j = yDiff % selectionDimensions.y();
         if (i < 0) i = selectionDimensions.x() + i;
         if (j < 0) j = selectionDimensions.y() + j;
         int index = j * selectionDimensions.x() + i;
         uint16_t metatileId = selectedMetatiles.at(index).metatileId;
-        uint16_t old_metatileId = block.metatileId;
-        if (selectedMetatiles.at(index).enabled && (selectedMetatiles.count() != 1 || old_metatileId != metatileId)) {
+        if (selectedMetatiles.at(index).enabled && (selectedMetatiles.count() != 1 || block.metatileId != metatileId)) {
             block.metatileId = metatileId;
             if (setCollisions) {
                 CollisionSelectionItem item = selectedCollisions.at(index);
                 block.collision = item.collision;
                 block.elevation = item.elevation;
             }
-            map->setBlock(x, y, block, !fromScriptCall);
-        }
-        if (!visited.contains(x + 1 + y * map->getWidth()) && map->getBlock(x + 1, y, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x + 1, y));
-            visited.insert(x + 1 + y * map->getWidth());
-        }
-        if (!visited.contains(x - 1 + y * map->getWidth()) && map->getBlock(x - 1, y, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x - 1, y));
-            visited.insert(x - 1 + y * map->getWidth());
-        }
-        if (!visited.contains(x + (y + 1) * map->getWidth()) && map->getBlock(x, y + 1, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x, y + 1));
-            visited.insert(x + (y + 1) * map->getWidth());
-        }
-        if (!visited.contains(x + (y - 1) * map->getWidth()) && map->getBlock(x, y - 1, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x, y - 1));
-            visited.insert(x + (y - 1) * map->getWidth());
+            updates.append(BlockUpdate{blockIndex, block});
         }
     }
+    map->setBlocks(updates, !fromScriptCall);
 
     if (!fromScriptCall && map->layout->blockdata != oldMetatiles) {
         map->editHistory.push(new BucketFillMetatile(map, oldMetatiles, map->layout->blockdata, actionId_));
@@ -586,45 +569,27 @@ void MapPixmapItem::floodFillSmartPath(int initialX, int initialY, bool fromScri
     Blockdata oldMetatiles = !fromScriptCall ? map->layout->blockdata : Blockdata();
 
     // Flood fill the region with the open tile.
-    QList<QPoint> todo;
-    todo.append(QPoint(initialX, initialY));
-    while (todo.length()) {
-        QPoint point = todo.takeAt(0);
-        int x = point.x();
-        int y = point.y();
-        Block block;
-        if (!map->getBlock(x, y, &block)) {
-            continue;
-        }
-
-        uint16_t old_metatileId = block.metatileId;
-        if (old_metatileId == openTile) {
-            continue;
-        }
-
-        block.metatileId = openTile;
-        if (setCollisions) {
-            block.collision = openTileCollision;
-            block.elevation = openTileElevation;
-        }
-        map->setBlock(x, y, block, !fromScriptCall);
-        if (map->getBlock(x + 1, y, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x + 1, y));
-        }
-        if (map->getBlock(x - 1, y, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x - 1, y));
-        }
-        if (map->getBlock(x, y + 1, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x, y + 1));
-        }
-        if (map->getBlock(x, y - 1, &block) && block.metatileId == old_metatileId) {
-            todo.append(QPoint(x, y - 1));
+    Block initialBlock;
+    if (map->getBlock(initialX, initialY, &initialBlock) && initialBlock.metatileId != openTile) {
+        const QVector<int> area = map->getFloodFillArea(initialX, initialY, Block::metatileIdMask);
+        QVector<BlockUpdate> updates;
+        updates.reserve(area.size());
+        for (int blockIndex : area) {
+            Block block = map->layout->blockdata.at(blockIndex);
+            block.metatileId = openTile;
+            if (setCollisions) {
+                block.collision = openTileCollision;
+                block.elevation = openTileElevation;
+            }
+            updates.append(BlockUpdate{blockIndex, block});
         }
+        map->setBlocks(updates, !fromScriptCall);
     }
 
     // Go back and resolve the flood-filled edge tiles.
     // Mark tiles as visited while we go.
     QSet<int> visited;
+    QList<QPoint> todo;
     todo.append(QPoint(initialX, initialY));
     while (todo.length()) {
         QPoint point = todo.takeAt(0);
@@ -725,10 +690,46 @@ void MapPixmapItem::select(QGraphicsSceneMouseEvent *event) {
 void MapPixmapItem::draw(bool ignoreCache) {
     if (map) {
         map->setMapItem(this);
-        setPixmap(map->render(ignoreCache));
+        updateChunks(map->takeDirtyMapItemArea(), ignoreCache);
+    }
+}
+
+// Chunks are rendered when they're painted, so this only marks the changed areas to be redrawn.
+void MapPixmapItem::updateChunks(const QRect &dirtyArea, bool ignoreCache) {
+    QSize mapSize(map->getWidth(), map->getHeight());
+    if (mapSize != chunks.getMapSize()) {
+        prepareGeometryChange();
+        chunks.setMapSize(mapSize);
+        update();
+    } else if (ignoreCache) {
+        chunks.invalidateAll();
+        update();
+    } else if (!dirtyArea.isEmpty()) {
+        chunks.invalidate(dirtyArea);
+        update(QRectF(dirtyArea.x() * 16, dirtyArea.y() * 16, dirtyArea.width() * 16, dirtyArea.height() * 16));
     }
 }
 
+void MapPixmapItem::renderChunk(QImage *image, const QRect &area) {
+    map->renderMetatiles(image, area);
+}
+
+QRectF MapPixmapItem::boundingRect() const {
+    QSize mapSize = chunks.getMapSize();
+    return QRectF(0, 0, mapSize.width() * 16, mapSize.height() * 16);
+}
+
+QPainterPath MapPixmapItem::shape() const {
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
+}
+
+void MapPixmapItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *) {
+    // The exposed rect is the part of the item visible in the view, at the view's current zoom level.
+    chunks.paint(painter, option->exposedRect);
+}
+
 void MapPixmapItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
     QPoint pos = Metatile::coordFromPixmapCoord(event->pos());
     if (pos != this->metatilePos) {
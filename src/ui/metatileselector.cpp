@@ -1,7 +1,6 @@
 #include "imageproviders.h"
 #include "metatileselector.h"
 #include "project.h"
-#include <QPainter>
 
 QPoint MetatileSelector::getSelectionDimensions() {
     return selection.dimensions;
@@ -20,7 +19,6 @@ void MetatileSelector::draw() {
     }
     QImage image(this->numMetatilesWide * 16, height_ * 16, QImage::Format_RGBA8888);
     image.fill(Qt::magenta);
-    QPainter painter(&image);
     for (int i = 0; i < length_; i++) {
         int tile = i;
         if (i >= primaryLength) {
@@ -30,10 +28,9 @@ void MetatileSelector::draw() {
         int map_y = i / this->numMetatilesWide;
         int map_x = i % this->numMetatilesWide;
         QPoint metatile_origin = QPoint(map_x * 16, map_y * 16);
-        painter.drawImage(metatile_origin, metatile_image);
+        drawMetatileImage(&image, metatile_origin, metatile_image);
     }
 
-    painter.end();
     this->setPixmap(QPixmap::fromImage(image));
 
     if (!this->prefabSelection && (!this->externalSelection || (this->externalSelectionWidth == 1 && this->externalSelectionHeight == 1))) {
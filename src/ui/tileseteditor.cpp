@@ -1085,6 +1085,15 @@ void TilesetEditor::countTileUsage() {
     QSet<Tileset*> primaryTilesets;
     QSet<Tileset*> secondaryTilesets;
 
+    // Start loading all the tilesets that need to be checked, so they can be decoded in parallel
+    for (auto layout : this->project->mapLayouts.values()) {
+        if (layout->tileset_primary_label == this->primaryTileset->name
+         || layout->tileset_secondary_label == this->secondaryTileset->name) {
+            this->project->prefetchTileset(layout->tileset_primary_label);
+            this->project->prefetchTileset(layout->tileset_secondary_label);
+        }
+    }
+
     for (auto layout : this->project->mapLayouts.values()) {
         if (layout->tileset_primary_label == this->primaryTileset->name
          || layout->tileset_secondary_label == this->secondaryTileset->name) {
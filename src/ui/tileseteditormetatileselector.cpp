@@ -36,7 +36,6 @@ QImage TilesetEditorMetatileSelector::buildImage(int metatileIdStart, int numMet
 
     QImage image(this->numMetatilesWide * 32, numMetatilesHigh * 32, QImage::Format_RGBA8888);
     image.fill(Qt::magenta);
-    QPainter painter(&image);
     for (int i = 0; i < numMetatiles; i++) {
         int metatileId = i + metatileIdStart;
         if (includesPrimary && metatileId >= numPrimary)
@@ -52,9 +51,8 @@ QImage TilesetEditorMetatileSelector::buildImage(int metatileIdStart, int numMet
         int map_y = i / this->numMetatilesWide;
         int map_x = i % this->numMetatilesWide;
         QPoint metatile_origin = QPoint(map_x * 32, map_y * 32);
-        painter.drawImage(metatile_origin, metatile_image);
+        drawMetatileImage(&image, metatile_origin, metatile_image);
     }
-    painter.end();
     return image;
 }
 
@@ -18,8 +18,8 @@ void TilesetEditorTileSelector::draw() {
     }
 
     int totalTiles = Project::getNumTilesTotal();
-    int primaryLength = this->primaryTileset->tiles.length();
-    int secondaryLength = this->secondaryTileset->tiles.length();
+    int primaryLength = this->primaryTileset->numTiles();
+    int secondaryLength = this->secondaryTileset->numTiles();
     int height = totalTiles / this->numTilesWide;
     QList<QRgb> palette = Tileset::getPalette(this->paletteId, this->primaryTileset, this->secondaryTileset, true);
     QImage image(this->numTilesWide * 16, height * 16, QImage::Format_RGBA8888);
@@ -223,7 +223,7 @@ QImage TilesetEditorTileSelector::buildPrimaryTilesIndexedImage() {
         return QImage();
     }
 
-    int primaryLength = this->primaryTileset->tiles.length();
+    int primaryLength = this->primaryTileset->numTiles();
     int height = qCeil(primaryLength / static_cast<double>(this->numTilesWide));
     QImage image(this->numTilesWide * 8, height * 8, QImage::Format_RGBA8888);
 
@@ -258,7 +258,7 @@ QImage TilesetEditorTileSelector::buildSecondaryTilesIndexedImage() {
         return QImage();
     }
 
-    int secondaryLength = this->secondaryTileset->tiles.length();
+    int secondaryLength = this->secondaryTileset->numTiles();
     int height = qCeil(secondaryLength / static_cast<double>(this->numTilesWide));
     QImage image(this->numTilesWide * 8, height * 8, QImage::Format_RGBA8888);
 